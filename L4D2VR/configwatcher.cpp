@@ -0,0 +1,98 @@
+#include "configwatcher.h"
+
+#ifdef _WIN32
+#include <Windows.h>
+
+bool ConfigWatcher::Open(const char *directory)
+{
+	Close();
+
+	HANDLE handle = FindFirstChangeNotificationA(directory, false, FILE_NOTIFY_CHANGE_LAST_WRITE | FILE_NOTIFY_CHANGE_FILE_NAME);
+	if (handle == INVALID_HANDLE_VALUE)
+		return false;
+
+	m_Handle = handle;
+	return true;
+}
+
+void ConfigWatcher::Close()
+{
+	if (m_Handle)
+	{
+		FindCloseChangeNotification(m_Handle);
+		m_Handle = nullptr;
+	}
+}
+
+bool ConfigWatcher::WaitForChange(int timeoutMs)
+{
+	if (!m_Handle)
+		return false;
+
+	if (WaitForSingleObject(m_Handle, timeoutMs == WAIT_INFINITE ? INFINITE : (DWORD)timeoutMs) != WAIT_OBJECT_0)
+		return false;
+
+	FindNextChangeNotification(m_Handle);
+	return true;
+}
+
+#else
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+bool ConfigWatcher::Open(const char *directory)
+{
+	Close();
+
+	m_Fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (m_Fd < 0)
+		return false;
+
+	// Editors that save by renaming a temp file over the original only produce IN_MOVED_TO
+	if (inotify_add_watch(m_Fd, directory, IN_CLOSE_WRITE | IN_MODIFY | IN_MOVED_TO | IN_CREATE) < 0)
+	{
+		Close();
+		return false;
+	}
+
+	return true;
+}
+
+void ConfigWatcher::Close()
+{
+	if (m_Fd >= 0)
+	{
+		close(m_Fd);
+		m_Fd = -1;
+	}
+}
+
+bool ConfigWatcher::WaitForChange(int timeoutMs)
+{
+	if (m_Fd < 0)
+		return false;
+
+	pollfd pfd = { m_Fd, POLLIN, 0 };
+	if (poll(&pfd, 1, timeoutMs) <= 0)
+		return false;
+
+	// Drain everything queued, one change notification covers all of it
+	alignas(inotify_event) char buffer[4096];
+	while (read(m_Fd, buffer, sizeof(buffer)) > 0)
+		;
+
+	return true;
+}
+#endif
+
+bool ConfigWatcher::WaitForSettledChange(int timeoutMs, int settleMs)
+{
+	if (!WaitForChange(timeoutMs))
+		return false;
+
+	while (WaitForChange(settleMs))
+		;
+
+	return true;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstddef>
+#include <functional>
+#include <string>
+
+// Waits for files in a directory to change. Uses change notifications on Windows and inotify on Linux,
+// so the reload logic built on top of it can also be exercised outside the game.
+class ConfigWatcher
+{
+public:
+	static constexpr int WAIT_INFINITE = -1;
+
+	ConfigWatcher() = default;
+	ConfigWatcher(const ConfigWatcher &) = delete;
+	ConfigWatcher &operator=(const ConfigWatcher &) = delete;
+	~ConfigWatcher() { Close(); }
+
+	bool Open(const char *directory);
+	void Close();
+
+	// Returns true if something in the directory was written to before 'timeoutMs' ran out.
+	// Doesn't say which file, callers are expected to check the contents themselves.
+	bool WaitForChange(int timeoutMs);
+
+	// Waits for a change like WaitForChange, then until the directory was quiet for 'settleMs',
+	// so a burst of writes from an editor is reported once
+	bool WaitForSettledChange(int timeoutMs, int settleMs);
+
+private:
+#ifdef _WIN32
+	void *m_Handle = nullptr;
+#else
+	int m_Fd = -1;
+#endif
+};
+
+// Remembers what the last accepted config contained. The directory notification fires for every file in it,
+// and rewriting a file with the same contents is no reason to reload it.
+class ConfigContents
+{
+public:
+	bool IsNew(const std::string &contents) const { return !m_HasAccepted || std::hash<std::string>{}(contents) != m_Hash; }
+
+	void Accept(const std::string &contents)
+	{
+		m_Hash = std::hash<std::string>{}(contents);
+		m_HasAccepted = true;
+	}
+
+private:
+	size_t m_Hash = 0;
+	bool m_HasAccepted = false;
+};
@@ -0,0 +1,212 @@
+#include "frametiming.h"
+#include <Windows.h>
+#include <algorithm>
+#include <cstdio>
+#include <iostream>
+#include <mutex>
+#include <vector>
+
+namespace
+{
+	const char *STAGE_NAMES[Timing_Count] =
+	{
+		"Update",
+		"WaitGetPoses",
+		"SubmitVRTextures",
+		"AsyncSubmit",
+		"WaitForSubmit",
+		"UpdateTracking",
+		"ProcessInput",
+		"RenderView",
+		"RenderViewLeft",
+		"RenderViewRight",
+		"RenderViewWindow",
+		"TraceEye",
+		"PipelineWarmUp",
+	};
+
+	const char *COUNTER_NAMES[Counter_Count] =
+	{
+		"RenderContextAcquire",
+		"RenderContextRelease",
+		"RenderContextReuse",
+		"HudPaint",
+		"HudPaintSkipped",
+	};
+
+	constexpr size_t RING_CAPACITY = 8192;
+	constexpr uint64_t PRINT_INTERVAL_NS = 5000000000ull;
+
+	// Written only by its owning thread, read by whoever dumps
+	struct TimingRing
+	{
+		DWORD threadId;
+		std::atomic<uint64_t> count = 0;
+		TimingEvent events[RING_CAPACITY];
+	};
+
+	// Rings are never freed, threads like the tracking thread are detached and may record until exit
+	std::mutex g_RingsLock;
+	std::vector<TimingRing *> g_Rings;
+
+	uint64_t g_LastPrint = 0;
+
+	TimingRing &GetThreadRing()
+	{
+		thread_local TimingRing *ring = nullptr;
+		if (!ring)
+		{
+			ring = new TimingRing();
+			ring->threadId = GetCurrentThreadId();
+
+			std::lock_guard<std::mutex> lock(g_RingsLock);
+			g_Rings.push_back(ring);
+		}
+		return *ring;
+	}
+
+	// Copies the events of every ring, skipping the ones the owner may have overwritten while copying
+	void CollectEvents(std::vector<TimingEvent> &events, std::vector<DWORD> &threadIds)
+	{
+		std::lock_guard<std::mutex> lock(g_RingsLock);
+
+		for (TimingRing *ring : g_Rings)
+		{
+			const uint64_t end = ring->count.load(std::memory_order_acquire);
+			const uint64_t begin = end > RING_CAPACITY ? end - RING_CAPACITY : 0;
+
+			const size_t firstCopied = events.size();
+			for (uint64_t i = begin; i < end; ++i)
+				events.push_back(ring->events[i % RING_CAPACITY]);
+
+			// The owner may also be halfway through writing the slot after its last counted event
+			const uint64_t endAfter = ring->count.load(std::memory_order_acquire) + 1;
+			const uint64_t unsafeEnd = std::min(endAfter > RING_CAPACITY ? endAfter - RING_CAPACITY : 0, end);
+			if (unsafeEnd > begin)
+				events.erase(events.begin() + firstCopied, events.begin() + firstCopied + (unsafeEnd - begin));
+
+			threadIds.resize(events.size(), ring->threadId);
+		}
+	}
+}
+
+void FrameTiming::Record(TimingStage stage, uint64_t start, uint64_t end)
+{
+	TimingRing &ring = GetThreadRing();
+	const uint64_t index = ring.count.load(std::memory_order_relaxed);
+
+	ring.events[index % RING_CAPACITY] = { start, (uint32_t)std::min<uint64_t>(end - start, UINT32_MAX), (uint32_t)stage };
+	ring.count.store(index + 1, std::memory_order_release);
+}
+
+void FrameTiming::SetEnabled(bool enabled)
+{
+	if (s_Enabled.exchange(enabled) == enabled)
+		return;
+
+	if (enabled)
+	{
+		std::cout << "Frame timing enabled\n";
+		g_LastPrint = Now();
+		return;
+	}
+
+	PrintPercentiles();
+	if (Dump("VR\\frametiming.csv", "VR\\frametiming.json"))
+		std::cout << "Frame timing disabled, wrote VR\\frametiming.csv and VR\\frametiming.json\n";
+}
+
+void FrameTiming::Tick()
+{
+	if (!s_Enabled.load(std::memory_order_relaxed))
+		return;
+
+	s_CountedFrames.fetch_add(1, std::memory_order_relaxed);
+
+	const uint64_t now = Now();
+	if (now - g_LastPrint < PRINT_INTERVAL_NS)
+		return;
+
+	g_LastPrint = now;
+	PrintPercentiles();
+}
+
+void FrameTiming::PrintPercentiles()
+{
+	std::vector<TimingEvent> events;
+	std::vector<DWORD> threadIds;
+	CollectEvents(events, threadIds);
+
+	std::vector<uint32_t> durations[Timing_Count];
+	for (const TimingEvent &event : events)
+		durations[event.stage].push_back(event.duration);
+
+	const auto percentile = [](std::vector<uint32_t> &values, float p) -> float
+	{
+		auto nth = values.begin() + (size_t)(p * (values.size() - 1));
+		std::nth_element(values.begin(), nth, values.end());
+		return *nth / 1000000.0f;
+	};
+
+	char line[256];
+	std::cout << "Frame timing (ms)              p50      p95      p99  samples\n";
+	for (int stage = 0; stage < Timing_Count; ++stage)
+	{
+		std::vector<uint32_t> &values = durations[stage];
+		if (values.empty())
+			continue;
+
+		sprintf_s(line, sizeof(line), "  %-24s %8.3f %8.3f %8.3f %8zu\n", STAGE_NAMES[stage],
+			percentile(values, 0.5f), percentile(values, 0.95f), percentile(values, 0.99f), values.size());
+		std::cout << line;
+	}
+
+	const uint32_t frames = s_CountedFrames.exchange(0, std::memory_order_relaxed);
+	if (frames == 0)
+		return;
+
+	std::cout << "Per frame                   average   frames\n";
+	for (int counter = 0; counter < Counter_Count; ++counter)
+	{
+		const uint32_t count = s_Counters[counter].exchange(0, std::memory_order_relaxed);
+		sprintf_s(line, sizeof(line), "  %-24s %8.2f %8u\n", COUNTER_NAMES[counter], (float)count / frames, frames);
+		std::cout << line;
+	}
+}
+
+bool FrameTiming::Dump(const char *csvFile, const char *traceFile)
+{
+	std::vector<TimingEvent> events;
+	std::vector<DWORD> threadIds;
+	CollectEvents(events, threadIds);
+
+	FILE *csv = nullptr;
+	FILE *trace = nullptr;
+	if (fopen_s(&csv, csvFile, "w") != 0 || fopen_s(&trace, traceFile, "w") != 0)
+	{
+		if (csv)
+			fclose(csv);
+		std::cout << "Failed to write frame timing dump\n";
+		return false;
+	}
+
+	fprintf(csv, "thread,stage,start_us,duration_us\n");
+	fprintf(trace, "{\"traceEvents\":[\n");
+
+	for (size_t i = 0; i < events.size(); ++i)
+	{
+		const TimingEvent &event = events[i];
+		const double startUs = event.start / 1000.0;
+		const double durationUs = event.duration / 1000.0;
+
+		fprintf(csv, "%lu,%s,%.3f,%.3f\n", threadIds[i], STAGE_NAMES[event.stage], startUs, durationUs);
+		fprintf(trace, "%s{\"name\":\"%s\",\"ph\":\"X\",\"pid\":1,\"tid\":%lu,\"ts\":%.3f,\"dur\":%.3f}\n",
+			i ? "," : "", STAGE_NAMES[event.stage], threadIds[i], startUs, durationUs);
+	}
+
+	fprintf(trace, "]}\n");
+
+	fclose(csv);
+	fclose(trace);
+	return true;
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+enum TimingStage
+{
+	Timing_Update,
+	Timing_WaitGetPoses,
+	Timing_SubmitVRTextures,
+	Timing_AsyncSubmit,
+	Timing_WaitForSubmit,
+	Timing_UpdateTracking,
+	Timing_ProcessInput,
+	Timing_RenderView,
+	Timing_RenderViewLeft,
+	Timing_RenderViewRight,
+	Timing_RenderViewWindow,
+	Timing_TraceEye,
+	Timing_PipelineWarmUp,
+	Timing_Count
+};
+
+// Things worth counting per frame rather than timing
+enum TimingCounter
+{
+	Counter_RenderContextAcquire,
+	Counter_RenderContextRelease,
+	Counter_RenderContextReuse,
+	Counter_HudPaint,
+	Counter_HudPaintSkipped,
+	Counter_Count
+};
+
+struct TimingEvent
+{
+	uint64_t start;			// Nanoseconds since FrameTiming::Now() epoch
+	uint32_t duration;		// Nanoseconds
+	uint32_t stage;
+};
+
+// Low overhead stage timings for the render loop. Every thread records into its own ring buffer,
+// so recording never takes a lock. While disabled a ScopedTimer costs a single relaxed load.
+class FrameTiming
+{
+public:
+	static inline std::atomic<bool> s_Enabled = false;
+
+	static uint64_t Now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	static void Record(TimingStage stage, uint64_t start, uint64_t end);
+
+	static void Count(TimingCounter counter)
+	{
+		if (s_Enabled.load(std::memory_order_relaxed))
+			s_Counters[counter].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	// Turning timings off writes everything recorded so far to 'VR\\frametiming.csv' and 'VR\\frametiming.json' (chrome://tracing)
+	static void SetEnabled(bool enabled);
+
+	// Call once per frame, prints p50/p95/p99 of every stage and the per frame average of every counter
+	// every few seconds while enabled
+	static void Tick();
+
+	static void PrintPercentiles();
+	static bool Dump(const char *csvFile, const char *traceFile);
+
+private:
+	static inline std::atomic<uint32_t> s_Counters[Counter_Count] = {};
+	static inline std::atomic<uint32_t> s_CountedFrames = 0;
+};
+
+class ScopedTimer
+{
+public:
+	ScopedTimer(TimingStage stage)
+		: m_Stage(stage), m_Start(FrameTiming::s_Enabled.load(std::memory_order_relaxed) ? FrameTiming::Now() : 0)
+	{}
+
+	~ScopedTimer()
+	{
+		if (m_Start)
+			FrameTiming::Record(m_Stage, m_Start, FrameTiming::Now());
+	}
+
+private:
+	TimingStage m_Stage;
+	uint64_t m_Start;
+};
+
+#define TIME_SCOPE_CONCAT_(a, b) a##b
+#define TIME_SCOPE_CONCAT(a, b) TIME_SCOPE_CONCAT_(a, b)
+#define TIME_SCOPE(stage) ScopedTimer TIME_SCOPE_CONCAT(scopedTimer, __LINE__)(stage)
@@ -61,6 +61,18 @@ CBaseEntity *Game::GetClientEntity(int entityIndex)
     return (CBaseEntity *)(m_ClientEntityList->GetClientEntity(entityIndex));
 }
 
+void Game::UpdateFrameCache()
+{
+    m_LocalPlayerIndex = m_EngineClient->GetLocalPlayer();
+    C_BasePlayer *localPlayer = (C_BasePlayer *)GetClientEntity(m_LocalPlayerIndex);
+
+    // A new local player entity means a new level, entity pointers from the previous one may now belong to someone else
+    if (localPlayer != m_LocalPlayer)
+        m_PlayersVR.ClearEntityMap();
+
+    m_LocalPlayer = localPlayer;
+}
+
 char *Game::getNetworkName(uintptr_t *entity)
 {
     uintptr_t *IClientNetworkableVtable = (uintptr_t *)*(entity + 0x8);
@@ -2,6 +2,7 @@
 #include <cstdint>
 #include <array>
 #include "vector.h"
+#include "playervrtable.h"
 
 class IClientEntityList;
 class IEngineTrace;
@@ -27,22 +28,6 @@ class Hooks;
 
 inline Game *g_Game;
 
-struct Player
-{
-    C_BasePlayer *pPlayer;
-    bool isUsingVR;
-    QAngle controllerAngle;
-    Vector controllerPos;
-    QAngle prevControllerAngle;
-
-    Player()
-        : isUsingVR(false),
-        controllerAngle({ 0,0,0 }),
-        controllerPos({ 0,0,0 }),
-        prevControllerAngle({ 0,0,0 })
-    {}
-};
-
 class Game
 {
 public:
@@ -73,9 +58,13 @@ public:
 
     bool m_Initialized = false;
 
-    std::array<Player, 24> m_PlayersVRInfo;
+    PlayerVRTable m_PlayersVR;
     int m_CurrentUsercmdID = -1;
 
+    // Refreshed once per frame by UpdateFrameCache, the hooks ask for these far more often than they can change
+    int m_LocalPlayerIndex = -1;
+    C_BasePlayer *m_LocalPlayer = nullptr;
+
     model_t *m_ArmsModel = nullptr;
     IMaterial *m_ArmsMaterial = nullptr;
     bool m_CachedArmsModel = false;
@@ -87,6 +76,7 @@ public:
     static void errorMsg(const char *msg);
 
     CBaseEntity *GetClientEntity(int entityIndex);
+    void UpdateFrameCache();
     char *getNetworkName(uintptr_t *entity);
     void ClientCmd(const char *szCmdString);
     void ClientCmd_Unrestricted(const char *szCmdString);
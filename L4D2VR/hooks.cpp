@@ -5,7 +5,10 @@
 #include "sdk_server.h"
 #include "vr.h"
 #include "offsets.h"
+#include "frametiming.h"
+#include "rendercontext.h"
 #include <iostream>
+#include <algorithm>
 
 Hooks::Hooks(Game *game)
 {
@@ -19,6 +22,8 @@ Hooks::Hooks(Game *game)
 
 	m_PushHUDStep = -999;
 	m_PushedHud = true;
+	m_SkipHudPaint = false;
+	m_SkipHudPass = false;
 
 	initSourceHooks();
 
@@ -27,6 +32,8 @@ Hooks::Hooks(Game *game)
 
 	hkProcessUsercmds.enableHook();
 	hkReadUsercmd.enableHook();
+	if (hkPlayerRunCommand.pTarget)
+		hkPlayerRunCommand.enableHook();
 
 	//hkWriteUsercmdDeltaToBuffer.enableHook();
 	hkWriteUsercmd.enableHook();
@@ -85,6 +92,11 @@ int Hooks::initSourceHooks()
 	LPVOID ReadUserCmdAddr = (LPVOID)(m_Game->m_Offsets->ReadUserCmd.address);
 	hkReadUsercmd.createHook(ReadUserCmdAddr, &dReadUsercmd);
 
+	// Without it shots aim with the newest command that had fire down, see PlayerVRTable::BeginFire
+	LPVOID PlayerRunCommandAddr = (LPVOID)(m_Game->m_Offsets->PlayerRunCommand.address);
+	if (PlayerRunCommandAddr)
+		hkPlayerRunCommand.createHook(PlayerRunCommandAddr, &dPlayerRunCommand);
+
 	/*LPVOID WriteUsercmdDeltaToBufferAddr = (LPVOID)(m_Game->m_Offsets->WriteUsercmdDeltaToBuffer.address);
 	hkWriteUsercmdDeltaToBuffer.createHook(WriteUsercmdDeltaToBufferAddr, &dWriteUsercmdDeltaToBuffer);*/
 
@@ -211,17 +223,26 @@ ITexture* __fastcall Hooks::dGetRenderTarget(void* ecx, void* edx)
 
 void __fastcall Hooks::dRenderView(void *ecx, void *edx, CViewSetup &setup, CViewSetup &hudViewSetup, int nClearFlags, int whatToDraw)
 {
+	TIME_SCOPE(Timing_RenderView);
+
 	if (!m_VR->m_CreatedVRTextures) {
 		m_VR->CreateVRTextures();
 	}
 
-	if (m_Game->m_VguiSurface->IsCursorVisible())
+	if (m_VR->m_FrameState.m_IsCursorVisible)
 		return hkRenderView.fOriginal(ecx, setup, hudViewSetup, nClearFlags, whatToDraw);
 
 	//VPanel* g_pFullscreenRootPanel = *(VPanel**)(m_Game->m_Offsets->g_pFullscreenRootPanel.address);
 
 	IMaterialSystem* matSystem = m_Game->m_MaterialSystem;
 
+	// Late latch: pick up HMD poses that arrived since VR::Update so the eyes use the freshest pose
+	if (m_VR->LatchPoses())
+	{
+		m_VR->GetPoses();
+		m_VR->UpdateHMDTracking();
+	}
+
 	hudViewSetup.width = m_VR->m_RenderWidth;
 	hudViewSetup.height = m_VR->m_RenderHeight;
 	hudViewSetup.fov = m_VR->m_Fov;
@@ -278,38 +299,66 @@ void __fastcall Hooks::dRenderView(void *ecx, void *edx, CViewSetup &setup, CVie
 	CViewSetup leftEyeView = setup;
 	CViewSetup rightEyeView = setup;
 
-	int playerIndex = m_Game->m_EngineClient->GetLocalPlayer();
-	C_BasePlayer* localPlayer = (C_BasePlayer*)m_Game->GetClientEntity(playerIndex);
+	// Dynamic resolution only changes how much of the eye texture gets rendered into
+	m_VR->m_ViewportWidth = std::min((uint32_t)(m_VR->m_RenderWidth * m_VR->m_ResolutionScale), m_VR->m_EyeTextureWidth);
+	m_VR->m_ViewportHeight = std::min((uint32_t)(m_VR->m_RenderHeight * m_VR->m_ResolutionScale), m_VR->m_EyeTextureHeight);
+
+	leftEyeView.width = rightEyeView.width = m_VR->m_ViewportWidth;
+	leftEyeView.height = rightEyeView.height = m_VR->m_ViewportHeight;
+	leftEyeView.m_nUnscaledWidth = rightEyeView.m_nUnscaledWidth = m_VR->m_ViewportWidth;
+	leftEyeView.m_nUnscaledHeight = rightEyeView.m_nUnscaledHeight = m_VR->m_ViewportHeight;
+
+	// Update() only runs at Present, refresh here too so a level change can't leave us with the previous level's player
+	m_Game->UpdateFrameCache();
+	C_BasePlayer* localPlayer = m_Game->m_LocalPlayer;
+
+	// Both eyes are traced together, they're only an IPD apart
+	QAngle leftEyeAngle, rightEyeAngle;
+	m_VR->ResolveEyeOrigins((uint32_t*)localPlayer, position, QAngle(setup.angles.x, setup.angles.y, setup.angles.z),
+		leftEyeView.origin, leftEyeAngle, rightEyeView.origin, rightEyeAngle);
+	leftEyeView.angles.y = leftEyeAngle.y;
+	rightEyeView.angles.y = rightEyeAngle.y;
 
-	// Left eye CViewSetup
-	QAngle tempAngle = QAngle(setup.angles.x, setup.angles.y, setup.angles.z);
-	leftEyeView.origin = m_VR->TraceEye((uint32_t*)localPlayer, position, m_VR->GetViewOriginLeft(position), tempAngle);
-	leftEyeView.angles.y = tempAngle.y;
+	// The compositor may still be reading the textures of the last frame, render into the next set
+	m_VR->AcquireNextEyeTextureSet();
+
+	EyeTextureSet &textureSet = m_VR->m_EyeTextureSets[m_VR->m_EyeTextureSetIndex];
+	textureSet.m_RenderPose = m_VR->m_HmdPoseMatrix;
+	textureSet.m_RenderZNear = setup.zNear;
+	textureSet.m_RenderZFar = setup.zFar;
+
+	// Held until the end of the frame, the hooks the original RenderView calls into reuse it
+	RenderContextScope rndrContext(matSystem);
+
+	// The HUD goes to its own texture and camera monitors are rendered from the camera, both look the same from
+	// either eye. With shared passes only the left eye renders them.
+	const bool sharedPasses = m_VR->UseSharedEyePasses();
+	const int rightWhatToDraw = sharedPasses ? (whatToDraw & ~RENDERVIEW_DRAWHUD) | RENDERVIEW_SUPPRESSMONITORRENDERING : whatToDraw;
+	const uint64_t eyesStart = FrameTiming::Now();
 
 	//std::cout << "dRenderView - Left Start\n";
-	IMatRenderContext* rndrContext = matSystem->GetRenderContext();
 	rndrContext->SetRenderTarget(m_VR->m_LeftEyeTexture);
-	rndrContext->Release();
-	hkRenderView.fOriginal(ecx, leftEyeView, hudViewSetup, nClearFlags, whatToDraw);
+	{
+		TIME_SCOPE(Timing_RenderViewLeft);
+		hkRenderView.fOriginal(ecx, leftEyeView, hudViewSetup, nClearFlags, whatToDraw);
+	}
 	
 	// Right eye CViewSetup
-	tempAngle = QAngle(setup.angles.x, setup.angles.y, setup.angles.z);
-	rightEyeView.origin = m_VR->TraceEye((uint32_t*)localPlayer, position, m_VR->GetViewOriginRight(position), tempAngle);
-	rightEyeView.angles.y = tempAngle.y;
-
 	//std::cout << "dRenderView - Right Start\n";
-	rndrContext = matSystem->GetRenderContext();
 	rndrContext->SetRenderTarget(m_VR->m_RightEyeTexture);
-	rndrContext->Release();
-	hkRenderView.fOriginal(ecx, rightEyeView, hudViewSetup, nClearFlags, whatToDraw);
+	{
+		TIME_SCOPE(Timing_RenderViewRight);
+		m_SkipHudPass = sharedPasses;
+		hkRenderView.fOriginal(ecx, rightEyeView, hudViewSetup, nClearFlags, rightWhatToDraw);
+		m_SkipHudPass = false;
+	}
 
+	m_VR->EndStereoBenchmarkFrame(FrameTiming::Now() - eyesStart);
 	m_PushedHud = false;
 
 
 
-	rndrContext = matSystem->GetRenderContext();
 	rndrContext->SetRenderTarget(NULL);
-	rndrContext->Release();
 
 	/*rndrContext = matSystem->GetRenderContext();
 
@@ -327,12 +376,17 @@ void __fastcall Hooks::dRenderView(void *ecx, void *edx, CViewSetup &setup, CVie
 	rndrContext->SetRenderTarget(NULL);
 	rndrContext->Release();*/
 
-	if (m_VR->m_RenderWindow) {
+	if (m_VR->m_RenderWindow == 1) {
 		setup.m_flAspectRatio = aspect;
 
 		//setup.width, setup.height
+		TIME_SCOPE(Timing_RenderViewWindow);
 		hkRenderView.fOriginal(ecx, setup, hudViewSetup, nClearFlags, whatToDraw);
 	}
+	else if (m_VR->m_RenderWindow == 2) {
+		TIME_SCOPE(Timing_RenderViewWindow);
+		m_VR->MirrorToWindow();
+	}
 
 
 	m_VR->m_RenderedNewFrame = true;
@@ -437,6 +491,10 @@ float __fastcall Hooks::dProcessUsercmds(void *ecx, void *edx, edict_t *player,
 	int index = EntityIndex(pPlayer);
 	m_Game->m_CurrentUsercmdID = index;
 
+	// Keeps the entity to slot cache right if a player entity gets reused for someone else
+	if (PlayerVRTable::IsValidSlot(index))
+		m_Game->m_PlayersVR.MapEntity(pPlayer, index);
+
 	return hkProcessUsercmds.fOriginal(ecx, player, buf, numcmds, totalcmds, dropped_packets, ignore, paused);
 }
 
@@ -447,12 +505,21 @@ int Hooks::dWriteUsercmd(bf_write *buf, CUserCmd *to, CUserCmd *from)
 	// Let's write our stuff into the buffer
 	if (m_VR->m_IsVREnabled)
 	{
-		Vector controllerPos = m_VR->GetRightControllerAbsPos();
-		QAngle controllerAngles = m_VR->GetRightControllerAbsAngle();
+		// Commands get resent until they're acked, a resent command has to carry the same poses
+		// or the commands delta encoded against it would decode differently on the server
+		VRUsercmdPayload payload;
+		if (const VRUsercmdPayload *sent = m_VR->m_SentUsercmds.Find(to->command_number))
+		{
+			payload = *sent;
+		}
+		else
+		{
+			m_VR->GetUsercmdPayload(payload);
+			m_VR->m_SentUsercmds.Store(to->command_number, payload);
+		}
 
-		buf->WriteChar(-2);
-		buf->WriteBitVec3Coord(controllerPos);
-		buf->WriteBitAngles(controllerAngles);
+		const int baseline = VRUsercmd::BaselineCommand(to->command_number, from ? from->command_number : 0);
+		VRUsercmd::Write(buf, payload, m_VR->m_SentUsercmds.Find(baseline));
 	}
 
 	return result;
@@ -463,26 +530,74 @@ int Hooks::dReadUsercmd(bf_read *buf, CUserCmd* move, CUserCmd* from)
 	auto result = hkReadUsercmd.fOriginal(buf, move, from);
 
 	int i = m_Game->m_CurrentUsercmdID;
-	auto& vrPlayer = m_Game->m_PlayersVRInfo[i];
+	PlayerVRTable &players = m_Game->m_PlayersVR;
 
 	auto pos = buf->Tell();
 	int res = buf->ReadChar();
 
-	// This means we got a VR player on the other side
-	if (res == -2)
+	if (res != VRUsercmd::MARKER && res != VRUsercmd::LEGACY_MARKER)
 	{
-		vrPlayer.isUsingVR = true;
-		buf->ReadBitVec3Coord(vrPlayer.controllerPos);
-		buf->ReadBitAngles(vrPlayer.controllerAngle);
-	}
-	else {
-		vrPlayer.isUsingVR = false;
 		buf->Seek(pos);
+		if (PlayerVRTable::IsValidSlot(i))
+			players.SetUsingVR(i, false);
+
+		return result;
+	}
+
+	// This means we got a VR player on the other side. The payload has to be read even if we can't store it.
+	VRUsercmdPayload payload;
+	bool decoded;
+	if (res == VRUsercmd::MARKER)
+	{
+		const int baselineCommand = VRUsercmd::BaselineCommand(move->command_number, from ? from->command_number : 0);
+		const VRUsercmdPayload *baseline = PlayerVRTable::IsValidSlot(i) ? players.m_UsercmdHistory[i].Find(baselineCommand) : nullptr;
+		decoded = VRUsercmd::Read(buf, payload, baseline);
+	}
+	else
+	{
+		Vector controllerPos;
+		QAngle controllerAngle;
+		buf->ReadBitVec3Coord(controllerPos);
+		buf->ReadBitAngles(controllerAngle);
+		payload.SetPose(VRDevice_RightController, controllerPos, controllerAngle);
+		decoded = true;
 	}
 
+	if (!PlayerVRTable::IsValidSlot(i))
+		return result;
+
+	players.SetUsingVR(i, true);
+
+	// On a decoding error keep the last good poses, decoding picks up again at the next keyframe.
+	// The pose history doesn't get them either, they'd be filed under the tick of this command.
+	if (!decoded)
+		return result;
+
+	if (res == VRUsercmd::MARKER)
+		players.m_UsercmdHistory[i].Store(move->command_number, payload);
+
+	payload.GetPose(VRDevice_RightController, players.m_ControllerPos[i], players.m_ControllerAngle[i]);
+	payload.GetPose(VRDevice_LeftController, players.m_LeftControllerPos[i], players.m_LeftControllerAngle[i]);
+	payload.GetPose(VRDevice_Hmd, players.m_HmdPos[i], players.m_HmdAngle[i]);
+
+	players.AddUsercmd(i, move->tick_count, (move->buttons & (IN_ATTACK | IN_ATTACK2)) != 0);
+
 	return result;
 }
 
+void __fastcall Hooks::dPlayerRunCommand(void *ecx, void *edx, CUserCmd *ucmd, void *moveHelper)
+{
+	int index = PlayerSlot(ecx);
+	bool vrPlayer = m_Game->m_PlayersVR.IsUsingVR(index);
+	if (vrPlayer)
+		m_Game->m_PlayersVR.BeginCommand(index, ucmd->tick_count);
+
+	hkPlayerRunCommand.fOriginal(ecx, ucmd, moveHelper);
+
+	if (vrPlayer)
+		m_Game->m_PlayersVR.EndCommand(index);
+}
+
 
 void Hooks::dAdjustEngineViewport(int &x, int &y, int &width, int &height)
 {
@@ -541,24 +656,26 @@ void Hooks::dPushRenderTargetAndViewport(void *ecx, void *edx, ITexture *pTextur
 {
 	if (m_VR->m_CreatedVRTextures && !m_PushedHud)
 	{
+		// The first push after the eyes is the HUD pass. Unless the HUD overlay needs a new texture it goes
+		// to whatever target the game asked for and dVGui_Paint paints nothing.
+		m_VR->m_RenderedHud = true;
+		m_PushedHud = true;
+		m_SkipHudPaint = !m_VR->BeginHudPaint();
+		if (m_SkipHudPaint)
+			return hkPushRenderTargetAndViewport.fOriginal(ecx, pTexture, pDepthTexture, nViewX, nViewY, nViewW, nViewH);
+
 		pTexture = m_VR->m_HUDTexture;
 
 		//pTexture = m_VR->m_RightEyeTexture;
 
-		IMatRenderContext *renderContext = m_Game->m_MaterialSystem->GetRenderContext();
+		RenderContextScope renderContext(m_Game->m_MaterialSystem);
 		renderContext->ClearBuffers(false, true, true);
-		renderContext->Release();
 
 		hkPushRenderTargetAndViewport.fOriginal(ecx, pTexture, pDepthTexture, nViewX, nViewY, nViewW, nViewH);
 
-		renderContext = m_Game->m_MaterialSystem->GetRenderContext();
 		renderContext->OverrideAlphaWriteEnable(true, true);
 		renderContext->ClearColor4ub(0, 0, 0, 0);
 		renderContext->ClearBuffers(true, false);
-		renderContext->Release();
-
-		m_VR->m_RenderedHud = true;
-		m_PushedHud = true;
 	}
 	else
 	{
@@ -574,13 +691,13 @@ void Hooks::dPopRenderTargetAndViewport(void *ecx, void *edx)
 	//std::cout << "dPopRenderTargetAndViewport: " << m_PushHUDStep << "\n";
 
 	m_PushHUDStep = 0;
+	m_SkipHudPaint = false;
 
 	if (m_PushedHud)
 	{
-		IMatRenderContext* renderContext = m_Game->m_MaterialSystem->GetRenderContext();
+		RenderContextScope renderContext(m_Game->m_MaterialSystem);
 		renderContext->OverrideAlphaWriteEnable(false, true);
 		renderContext->ClearColor4ub(0, 0, 0, 255);
-		renderContext->Release();
 	}
 
 	hkPopRenderTargetAndViewport.fOriginal(ecx);
@@ -588,12 +705,14 @@ void Hooks::dPopRenderTargetAndViewport(void *ecx, void *edx)
 
 void Hooks::dVGui_Paint(void *ecx, void *edx, int mode)
 {
-	if (!m_VR->m_CreatedVRTextures || m_VR->m_Game->m_VguiSurface->IsCursorVisible())
+	if (!m_VR->m_CreatedVRTextures || m_VR->m_FrameState.m_IsCursorVisible)
 		return hkVgui_Paint.fOriginal(ecx, mode);
 
 	//std::cout << "dVGui_Paint\n";
 
-	if (m_PushedHud)
+	if (m_SkipHudPaint || m_SkipHudPass)
+		mode = 0;
+	else if (m_PushedHud)
 		mode = PAINT_UIPANELS | PAINT_INGAMEPANELS;
 
 	hkVgui_Paint.fOriginal(ecx, mode);
@@ -627,17 +746,15 @@ Vector* Hooks::dWeapon_ShootPosition(void* ecx, void* edx, Vector* eyePos)
 {
 	Vector* result = hkWeapon_ShootPosition.fOriginal(ecx, eyePos);
 
-	int localIndex = m_Game->m_EngineClient->GetLocalPlayer();
-	int index = EntityIndex(ecx);
-
-	auto& vrPlayer = m_Game->m_PlayersVRInfo[index];
+	int localIndex = m_Game->m_LocalPlayerIndex;
+	int index = PlayerSlot(ecx);
 
 	if (m_VR->m_IsVREnabled && localIndex == index) {
 		*result = m_VR->GetRightControllerAbsPos();	
 	}
-	else if (vrPlayer.isUsingVR)
+	else if (m_Game->m_PlayersVR.IsUsingVR(index))
 	{
-		*result = vrPlayer.controllerPos;
+		*result = m_Game->m_PlayersVR.AimControllerPos(index);
 	}
 
 	return result;
@@ -648,8 +765,18 @@ void* Hooks::dCWeaponPortalgun_FirePortal(void* ecx, void* edx, bool bPortal2, V
 
 	m_VR->m_OverrideEyeAngles = true;
 
+	void *owner = GetOwner(ecx);
+	int index = owner ? PlayerSlot(owner) : -1;
+
+	bool vrPlayerFiring = m_Game->m_PlayersVR.IsUsingVR(index);
+	if (vrPlayerFiring)
+		m_Game->m_PlayersVR.BeginFire(index);
+
 	auto result = hkCWeaponPortalgun_FirePortal.fOriginal(ecx, bPortal2, pVector);
 
+	if (vrPlayerFiring)
+		m_Game->m_PlayersVR.EndFire(index);
+
 	if (!wasTrue)
 		m_VR->m_OverrideEyeAngles = false;
 
@@ -662,24 +789,22 @@ bool __fastcall Hooks::dTraceFirePortal(void* ecx, void* edx, const Vector& vTra
 	Vector vNewDirection = vDirection;
 
 	if (iPlacedBy == 2) {
-		int localIndex = m_Game->m_EngineClient->GetLocalPlayer();
+		int localIndex = m_Game->m_LocalPlayerIndex;
 
 		auto owner = GetOwner(ecx);
 
 		if (owner) {
-			int index = EntityIndex(owner);
-
-			auto& vrPlayer = m_Game->m_PlayersVRInfo[index];
+			int index = PlayerSlot(owner);
 
 			if (m_VR->m_IsVREnabled && localIndex == index) {
 				vNewTraceStart = m_VR->GetRightControllerAbsPos();
 				vNewDirection = m_VR->m_RightControllerForward;
 			}
-			else if (vrPlayer.isUsingVR)
+			else if (m_Game->m_PlayersVR.IsUsingVR(index))
 			{
-				vNewTraceStart = vrPlayer.controllerPos;
+				vNewTraceStart = m_Game->m_PlayersVR.AimControllerPos(index);
 				Vector fwd, rt, up;
-				QAngle::AngleVectors(vrPlayer.controllerAngle, &fwd, &rt, &up);
+				QAngle::AngleVectors(m_Game->m_PlayersVR.AimControllerAngle(index), &fwd, &rt, &up);
 				vNewDirection = fwd;
 			}
 		}
@@ -740,8 +865,7 @@ int __fastcall Hooks::dDrawSelf(void* ecx, void* edx, int x, int y, int w, int h
 
 	if (m_VR->m_IsVREnabled)
 	{
-		int windowWidth, windowHeight;
-		m_Game->m_MaterialSystem->GetRenderContext()->GetWindowSize(windowWidth, windowHeight);
+		const VRFrameState &frameState = m_VR->m_FrameState;
 
 		Vector screen = { 0, 0, 0 };
 
@@ -749,10 +873,10 @@ int __fastcall Hooks::dDrawSelf(void* ecx, void* edx, int x, int y, int w, int h
 
 		//newZ = 1.0 / sqrt(vec.x * vec.x + vec.y * vec.y + vec.z * vec.z);
 
-		ScreenTransform(m_VR->m_AimPos, &screen, m_VR->m_RenderWidth, m_VR->m_RenderHeight);
+		ScreenTransform(m_VR->m_AimPos, &screen, frameState.m_RenderWidth, frameState.m_RenderHeight);
 
-		int offsetX = x - (windowWidth * 0.5f);
-		int offsetY = y - (windowHeight * 0.5f);
+		int offsetX = x - (frameState.m_WindowWidth * 0.5f);
+		int offsetY = y - (frameState.m_WindowHeight * 0.5f);
 
 		newX = screen.x + offsetX;
 		newY = screen.y + offsetY;
@@ -762,7 +886,7 @@ int __fastcall Hooks::dDrawSelf(void* ecx, void* edx, int x, int y, int w, int h
 }
 
 void __cdecl Hooks::dVGui_GetHudBounds(int slot, int& x, int& y, int& w, int& h) {
-	if (m_VR->m_IsVREnabled && !m_Game->m_VguiSurface->IsCursorVisible())
+	if (m_VR->m_IsVREnabled && !m_VR->m_FrameState.m_IsCursorVisible)
 	{
 		x = y = 0;
 		w = m_VR->m_RenderWidth;
@@ -775,7 +899,7 @@ void __cdecl Hooks::dVGui_GetHudBounds(int slot, int& x, int& y, int& w, int& h)
 }
 
 void __cdecl Hooks::dVGui_GetPanelBounds(int slot, int& x, int& y, int& w, int& h) {
-	if (m_VR->m_IsVREnabled && !m_Game->m_VguiSurface->IsCursorVisible())
+	if (m_VR->m_IsVREnabled && !m_VR->m_FrameState.m_IsCursorVisible)
 	{
 		x = y = 0;
 		w = m_VR->m_RenderWidth;
@@ -809,7 +933,8 @@ void __cdecl Hooks::dGetHudSize(int& w, int& h) {
 }
 
 void __fastcall Hooks::dPush2DView(void* ecx, void* edx, IMatRenderContext* pRenderContext, const CViewSetup& view, int nFlags, ITexture* pRenderTarget, void* frustumPlanes) {
-	m_PushedHud = false;
+	// Without the HUD pass the next push is something else, it must not be redirected into the HUD texture
+	m_PushedHud = m_SkipHudPass;
 
 	return hkPush2DView.fOriginal(ecx, pRenderContext, view, nFlags, pRenderTarget, frustumPlanes);
 }
@@ -889,21 +1014,32 @@ void __fastcall Hooks::dRotateObject(void* ecx, void* edx, void* pPlayer, float
 		m_VR->m_OverrideEyeAngles = false;
 }
 
+int Hooks::PlayerSlot(void *entity)
+{
+	int slot = m_Game->m_PlayersVR.FindSlot(entity);
+	if (slot < 0)
+	{
+		slot = EntityIndex(entity);
+		if (PlayerVRTable::IsValidSlot(slot))
+			m_Game->m_PlayersVR.MapEntity(entity, slot);
+	}
+
+	return slot;
+}
+
 // This is CPlayerBase, do we also need to hook CPortalPlayer? can the same function be used by both?
 // This works for release, but why was it crashing before??? TODO: buy a c++ book...
 QAngle& __fastcall Hooks::dEyeAngles(void* ecx, void* edx) {
 	if (m_VR->m_OverrideEyeAngles) {
-		int localIndex = m_Game->m_EngineClient->GetLocalPlayer();
-		int index = EntityIndex(ecx);
-
-		auto& vrPlayer = m_Game->m_PlayersVRInfo[index];
+		int localIndex = m_Game->m_LocalPlayerIndex;
+		int index = PlayerSlot(ecx);
 
 		if (m_VR->m_IsVREnabled && localIndex == index) {
 			return m_VR->GetRightControllerAbsAngleConst();
 		}
-		else if (vrPlayer.isUsingVR)
+		else if (m_Game->m_PlayersVR.IsUsingVR(index))
 		{
-			return vrPlayer.controllerAngle;
+			return m_Game->m_PlayersVR.AimControllerAngle(index);
 		}
 	}
 
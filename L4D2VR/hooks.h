@@ -76,6 +76,7 @@ typedef void(__thiscall *tEndFrame)(PVOID);
 typedef void(__thiscall *tCalcViewModelView)(void *thisptr, const Vector &eyePosition, const QAngle &eyeAngles);
 typedef float(__thiscall *tProcessUsercmds)(void *thisptr, edict_t *player, void *buf, int numcmds, int totalcmds, int dropped_packets, bool ignore, bool paused);
 typedef int(__cdecl *tReadUsercmd)(void *buf, CUserCmd *move, CUserCmd *from);
+typedef void(__thiscall *tPlayerRunCommand)(void *thisptr, CUserCmd *ucmd, void *moveHelper);
 typedef void(__thiscall *tWriteUsercmdDeltaToBuffer)(void *thisptr, int a1, void *buf, int from, int to, bool isnewcommand);
 typedef int(__cdecl *tWriteUsercmd)(void *buf, CUserCmd *to, CUserCmd *from);
 typedef int(__cdecl *tAdjustEngineViewport)(int &x, int &y, int &width, int &height);
@@ -155,6 +156,7 @@ public:
 	static inline Hook<tCalcViewModelView> hkCalcViewModelView;
 	static inline Hook<tProcessUsercmds> hkProcessUsercmds;
 	static inline Hook<tReadUsercmd> hkReadUsercmd;
+	static inline Hook<tPlayerRunCommand> hkPlayerRunCommand;
 	static inline Hook<tWriteUsercmdDeltaToBuffer> hkWriteUsercmdDeltaToBuffer;
 	static inline Hook<tWriteUsercmd> hkWriteUsercmd;
 	static inline Hook<tAdjustEngineViewport> hkAdjustEngineViewport;
@@ -227,6 +229,7 @@ public:
 	static int dClientFireTerrorBullets(int playerId, const Vector &vecOrigin, const QAngle &vecAngles, int a4, int a5, int a6, float a7);
 	static float __fastcall dProcessUsercmds(void *ecx, void *edx, edict_t *player, void *buf, int numcmds, int totalcmds, int dropped_packets, bool ignore, bool paused);
 	static int dReadUsercmd(bf_read *buf, CUserCmd *move, CUserCmd *from);
+	static void __fastcall dPlayerRunCommand(void *ecx, void *edx, CUserCmd *ucmd, void *moveHelper);
 	static int dWriteUsercmd(bf_write *buf, CUserCmd *to, CUserCmd *from);
 	static void dAdjustEngineViewport(int &x, int &y, int &width, int &height);
 	static void __fastcall dViewport(void *ecx, void *edx, int x, int y, int width, int height);
@@ -293,6 +296,8 @@ public:
 
 	static inline int m_PushHUDStep;
 	static inline bool m_PushedHud;
+	static inline bool m_SkipHudPaint; // In the HUD pass of a frame that doesn't repaint the HUD overlay
+	static inline bool m_SkipHudPass; // In a view that doesn't draw the HUD, its 2D view has no HUD pass to look for
 
 	static inline tCreatePingPointer CreatePingPointer;
 	static inline tGetPortalPlayer GetPortalPlayer;
@@ -302,6 +307,7 @@ public:
 	static inline tUTIL_IntersectRayWithPortal UTIL_IntersectRayWithPortal;
 	static inline tUTIL_Portal_AngleTransform UTIL_Portal_AngleTransform;
 	static inline tEntindex EntityIndex;
+	static int PlayerSlot(void *entity); // EntityIndex through m_Game->m_PlayersVR's pointer cache
 	static inline tGetOwner GetOwner;
 	static inline tGetFullScreenTexture GetFullScreenTexture;
 };
\ No newline at end of file
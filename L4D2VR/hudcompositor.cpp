@@ -0,0 +1,68 @@
+#include "hudcompositor.h"
+#include "frametiming.h"
+#include <utility>
+
+void HudCompositor::Create(vr::IVROverlay *overlay)
+{
+	overlay->CreateOverlay("HUDOverlayKey", "HUDOverlay", &m_Handle);
+}
+
+bool HudCompositor::BeginPaint(float updateRate)
+{
+	// Nobody looks at it, the texture is repainted before the overlay is shown again
+	if (!m_Wanted || m_Handle == vr::k_ulOverlayHandleInvalid)
+	{
+		FrameTiming::Count(Counter_HudPaintSkipped);
+		return false;
+	}
+
+	// Showing it for the first time doesn't wait for the update interval
+	const auto now = std::chrono::steady_clock::now();
+	if (m_Shown && updateRate > 0.0f && now - m_LastPaint < std::chrono::duration<float>(1.0f / updateRate))
+	{
+		FrameTiming::Count(Counter_HudPaintSkipped);
+		return false;
+	}
+
+	FrameTiming::Count(Counter_HudPaint);
+	m_LastPaint = now;
+	m_Repainted = true;
+	return true;
+}
+
+bool HudCompositor::TakeRepainted()
+{
+	return std::exchange(m_Repainted, false);
+}
+
+void HudCompositor::SetTexture(const vr::Texture_t &texture)
+{
+	vr::VROverlay()->SetOverlayTexture(m_Handle, &texture);
+}
+
+void HudCompositor::SetWanted(bool wanted)
+{
+	m_Wanted = wanted;
+	if (!wanted)
+		Hide();
+}
+
+void HudCompositor::ShowIfReady()
+{
+	if (!m_Wanted || m_Shown || !m_TextureQueued)
+		return;
+
+	vr::VROverlay()->ShowOverlay(m_Handle);
+	m_Shown = true;
+}
+
+void HudCompositor::Hide()
+{
+	if (m_Shown)
+		vr::VROverlay()->HideOverlay(m_Handle);
+
+	// Anything painted before this is stale by the time it's shown again
+	m_Shown = false;
+	m_Repainted = false;
+	m_TextureQueued = false;
+}
@@ -0,0 +1,42 @@
+#pragma once
+#include "openvr.h"
+#include <chrono>
+
+// Shows the VGUI HUD on its own overlay instead of in the eye textures. VGUI doesn't tell us which panels changed,
+// so the HUD is only repainted while the overlay is wanted, at most HudUpdateRate times a second, and the overlay
+// texture is only set on frames that repainted it. Every other frame the HUD pass paints nothing.
+class HudCompositor
+{
+public:
+	void Create(vr::IVROverlay *overlay);
+	vr::VROverlayHandle_t Handle() const { return m_Handle; }
+
+	// Called from the HUD pass of the frame being rendered. True if it should repaint the HUD texture,
+	// updateRate is in Hz and 0 repaints every frame.
+	bool BeginPaint(float updateRate);
+
+	// Whether the HUD texture was repainted since the last call, i.e. the overlay texture has to be set again
+	bool TakeRepainted();
+
+	// The HUD texture this frame repainted will be handed to the overlay, either right away or by the submit thread
+	void QueueTexture() { m_TextureQueued = true; }
+	void SetTexture(const vr::Texture_t &texture);
+
+	// ProcessInput's decision whether the HUD should be visible. It's only shown once a repainted texture reached it,
+	// so it never flashes whatever it showed last time.
+	void SetWanted(bool wanted);
+	bool IsWanted() const { return m_Wanted; }
+	bool IsShown() const { return m_Shown; }
+
+	// Called after the previously queued texture is known to have reached the overlay
+	void ShowIfReady();
+	void Hide();
+
+private:
+	vr::VROverlayHandle_t m_Handle = vr::k_ulOverlayHandleInvalid;
+	bool m_Wanted = false;
+	bool m_Shown = false;
+	bool m_Repainted = false;
+	bool m_TextureQueued = false;
+	std::chrono::steady_clock::time_point m_LastPaint;
+};
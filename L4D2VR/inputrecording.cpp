@@ -0,0 +1,278 @@
+#include "inputrecording.h"
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+
+namespace
+{
+	const char FILE_MAGIC[4] = { 'P', 'R', 'V', 'R' };
+
+	template <typename T>
+	bool Write(FILE *file, const T &value)
+	{
+		return fwrite(&value, sizeof(T), 1, file) == 1;
+	}
+
+	template <typename T>
+	bool Read(FILE *file, T &value)
+	{
+		return fread(&value, sizeof(T), 1, file) == 1;
+	}
+
+	// Only connected devices are written, the others read back zeroed
+	bool WritePoses(FILE *file, const vr::TrackedDevicePose_t (&poses)[vr::k_unMaxTrackedDeviceCount])
+	{
+		uint64_t connectedMask = 0;
+		for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+		{
+			if (poses[i].bDeviceIsConnected)
+				connectedMask |= 1ull << i;
+		}
+
+		bool ok = Write(file, connectedMask);
+		for (uint32_t i = 0; ok && i < vr::k_unMaxTrackedDeviceCount; ++i)
+		{
+			if (connectedMask & (1ull << i))
+				ok = Write(file, poses[i]);
+		}
+		return ok;
+	}
+
+	bool ReadPoses(FILE *file, vr::TrackedDevicePose_t (&poses)[vr::k_unMaxTrackedDeviceCount])
+	{
+		uint64_t connectedMask = 0;
+		if (!Read(file, connectedMask))
+			return false;
+
+		for (uint32_t i = 0; i < vr::k_unMaxTrackedDeviceCount; ++i)
+		{
+			poses[i] = {};
+			if ((connectedMask & (1ull << i)) && !Read(file, poses[i]))
+				return false;
+		}
+		return true;
+	}
+}
+
+bool InputRecording::SetMode(Mode mode, const char *fileName)
+{
+	if (mode == m_Mode)
+		return true;
+
+	Close();
+
+	if (mode == Mode_Off)
+		return true;
+
+	m_File = fopen(fileName, mode == Mode_Record ? "wb" : "rb");
+	if (!m_File)
+	{
+		std::cout << "Failed to open input recording " << fileName << "\n";
+		return false;
+	}
+
+	if (mode == Mode_Record)
+	{
+		fwrite(FILE_MAGIC, sizeof(FILE_MAGIC), 1, m_File);
+		Write(m_File, FILE_VERSION);
+	}
+	else
+	{
+		char magic[4] = {};
+		uint32_t version = 0;
+		if (fread(magic, sizeof(magic), 1, m_File) != 1 || memcmp(magic, FILE_MAGIC, sizeof(magic)) != 0
+			|| !Read(m_File, version) || version != FILE_VERSION)
+		{
+			std::cout << "Not a supported input recording: " << fileName << "\n";
+			fclose(m_File);
+			m_File = nullptr;
+			return false;
+		}
+	}
+
+	m_Mode = mode;
+	m_HasFrame = false;
+	m_FrameCount = 0;
+	std::cout << (mode == Mode_Record ? "Recording input to " : "Replaying input from ") << fileName << "\n";
+	return true;
+}
+
+bool InputRecording::NextFrame()
+{
+	if (m_Mode == Mode_Record)
+	{
+		if (m_HasFrame && !WriteFrame())
+		{
+			std::cout << "Failed to write input recording, stopping\n";
+			m_HasFrame = false;
+			Close();
+			return false;
+		}
+
+		m_Frame.m_Latched = false;
+		m_Frame.m_DigitalActions.clear();
+		m_Frame.m_AnalogActions.clear();
+		m_HasFrame = true;
+		++m_FrameCount;
+		return true;
+	}
+
+	if (m_Mode == Mode_Replay)
+	{
+		if (ReadFrame())
+		{
+			++m_FrameCount;
+			return true;
+		}
+
+		std::cout << "Input replay finished after " << m_FrameCount << " frames\n";
+		Close();
+	}
+
+	return false;
+}
+
+void InputRecording::RecordDigitalAction(vr::VRActionHandle_t handle, bool state, bool changed)
+{
+	auto &actions = m_Frame.m_DigitalActions;
+	if (std::none_of(actions.begin(), actions.end(), [handle](const auto &action) { return action.m_Handle == handle; }))
+		actions.push_back({ handle, state, changed });
+}
+
+void InputRecording::RecordAnalogAction(vr::VRActionHandle_t handle, bool valid, const vr::InputAnalogActionData_t &data)
+{
+	auto &actions = m_Frame.m_AnalogActions;
+	if (std::none_of(actions.begin(), actions.end(), [handle](const auto &action) { return action.m_Handle == handle; }))
+		actions.push_back({ handle, valid, data.x, data.y, data.z });
+}
+
+void InputRecording::ReplayDigitalAction(vr::VRActionHandle_t handle, bool &state, bool &changed) const
+{
+	state = false;
+	changed = false;
+
+	for (const auto &action : m_Frame.m_DigitalActions)
+	{
+		if (action.m_Handle == handle)
+		{
+			state = action.m_State;
+			changed = action.m_Changed;
+			return;
+		}
+	}
+}
+
+bool InputRecording::ReplayAnalogAction(vr::VRActionHandle_t handle, vr::InputAnalogActionData_t &data) const
+{
+	data = {};
+
+	for (const auto &action : m_Frame.m_AnalogActions)
+	{
+		if (action.m_Handle == handle)
+		{
+			data.bActive = action.m_Valid;
+			data.x = action.m_X;
+			data.y = action.m_Y;
+			data.z = action.m_Z;
+			return action.m_Valid;
+		}
+	}
+
+	return false;
+}
+
+bool InputRecording::WriteFrame()
+{
+	const RecordedFrame &frame = m_Frame;
+
+	bool ok = Write(m_File, frame.m_PoseAge) && Write(m_File, frame.m_FrameDelta)
+		&& Write(m_File, frame.m_LeftController) && Write(m_File, frame.m_RightController)
+		&& WritePoses(m_File, frame.m_Poses) && Write(m_File, (uint8_t)frame.m_Latched);
+
+	if (ok && frame.m_Latched)
+		ok = Write(m_File, frame.m_LatchedPoseAge) && WritePoses(m_File, frame.m_LatchedPoses);
+
+	const uint8_t digitalCount = (uint8_t)std::min<size_t>(frame.m_DigitalActions.size(), UINT8_MAX);
+	ok = ok && Write(m_File, digitalCount);
+	for (uint8_t i = 0; ok && i < digitalCount; ++i)
+	{
+		const auto &action = frame.m_DigitalActions[i];
+		ok = Write(m_File, action.m_Handle) && Write(m_File, (uint8_t)action.m_State) && Write(m_File, (uint8_t)action.m_Changed);
+	}
+
+	const uint8_t analogCount = (uint8_t)std::min<size_t>(frame.m_AnalogActions.size(), UINT8_MAX);
+	ok = ok && Write(m_File, analogCount);
+	for (uint8_t i = 0; ok && i < analogCount; ++i)
+	{
+		const auto &action = frame.m_AnalogActions[i];
+		ok = Write(m_File, action.m_Handle) && Write(m_File, (uint8_t)action.m_Valid)
+			&& Write(m_File, action.m_X) && Write(m_File, action.m_Y) && Write(m_File, action.m_Z);
+	}
+
+	return ok;
+}
+
+bool InputRecording::ReadFrame()
+{
+	RecordedFrame &frame = m_Frame;
+
+	uint8_t latched = 0;
+	if (!Read(m_File, frame.m_PoseAge) || !Read(m_File, frame.m_FrameDelta)
+		|| !Read(m_File, frame.m_LeftController) || !Read(m_File, frame.m_RightController)
+		|| !ReadPoses(m_File, frame.m_Poses) || !Read(m_File, latched))
+		return false;
+
+	frame.m_Latched = latched != 0;
+	if (frame.m_Latched && (!Read(m_File, frame.m_LatchedPoseAge) || !ReadPoses(m_File, frame.m_LatchedPoses)))
+		return false;
+
+	uint8_t digitalCount = 0;
+	if (!Read(m_File, digitalCount))
+		return false;
+
+	frame.m_DigitalActions.resize(digitalCount);
+	for (auto &action : frame.m_DigitalActions)
+	{
+		uint8_t state, changed;
+		if (!Read(m_File, action.m_Handle) || !Read(m_File, state) || !Read(m_File, changed))
+			return false;
+		action.m_State = state != 0;
+		action.m_Changed = changed != 0;
+	}
+
+	uint8_t analogCount = 0;
+	if (!Read(m_File, analogCount))
+		return false;
+
+	frame.m_AnalogActions.resize(analogCount);
+	for (auto &action : frame.m_AnalogActions)
+	{
+		uint8_t valid;
+		if (!Read(m_File, action.m_Handle) || !Read(m_File, valid)
+			|| !Read(m_File, action.m_X) || !Read(m_File, action.m_Y) || !Read(m_File, action.m_Z))
+			return false;
+		action.m_Valid = valid != 0;
+	}
+
+	return true;
+}
+
+void InputRecording::Close()
+{
+	if (m_Mode == Mode_Record && m_HasFrame)
+	{
+		m_HasFrame = false;
+		WriteFrame();
+	}
+
+	if (m_File)
+	{
+		fclose(m_File);
+		m_File = nullptr;
+	}
+
+	if (m_Mode == Mode_Record)
+		std::cout << "Recorded " << m_FrameCount << " frames of input\n";
+
+	m_Mode = Mode_Off;
+}
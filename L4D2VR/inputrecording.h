@@ -0,0 +1,93 @@
+#pragma once
+#include "openvr.h"
+#include <cstdint>
+#include <cstdio>
+#include <vector>
+
+// Everything InputSource read from OpenVR during one frame
+struct RecordedFrame
+{
+	struct DigitalAction
+	{
+		vr::VRActionHandle_t m_Handle;
+		bool m_State;
+		bool m_Changed;
+	};
+
+	struct AnalogAction
+	{
+		vr::VRActionHandle_t m_Handle;
+		bool m_Valid;
+		float m_X, m_Y, m_Z;
+	};
+
+	float m_PoseAge = 0.0f;			// Seconds the frame's photons are later than its poses were predicted for, see InputSource::GetPoseAge()
+	float m_FrameDelta = 0.0f;		// Seconds since the previous ProcessInput(), drives smooth turning
+	vr::TrackedDeviceIndex_t m_LeftController = vr::k_unTrackedDeviceIndexInvalid;
+	vr::TrackedDeviceIndex_t m_RightController = vr::k_unTrackedDeviceIndexInvalid;
+	vr::TrackedDevicePose_t m_Poses[vr::k_unMaxTrackedDeviceCount] = {};
+
+	// Poses the late latch swapped in after the frame's WaitGetPoses, if it did
+	bool m_Latched = false;
+	float m_LatchedPoseAge = 0.0f;
+	vr::TrackedDevicePose_t m_LatchedPoses[vr::k_unMaxTrackedDeviceCount] = {};
+	std::vector<DigitalAction> m_DigitalActions;
+	std::vector<AnalogAction> m_AnalogActions;
+};
+
+// Records what the tracking and input code reads from OpenVR to a file, or plays a recording back in its
+// place, so a session can be re-run frame by frame without anyone wearing the headset. Only depends on
+// openvr.h, a test or benchmark driver can read recordings without the game.
+//
+// File layout, little endian: "PRVR", uint32 version, then for every frame:
+//   float poseAge, float frameDelta, uint32 leftController, uint32 rightController,
+//   uint64 mask of connected devices followed by a TrackedDevicePose_t for every set bit,
+//   uint8 latched, if set followed by float latchedPoseAge and the latched poses in the same layout as above,
+//   uint8 count + { uint64 handle, uint8 state, uint8 changed } per digital action,
+//   uint8 count + { uint64 handle, uint8 valid, float x, y, z } per analog action
+class InputRecording
+{
+public:
+	enum Mode
+	{
+		Mode_Off,
+		Mode_Record,
+		Mode_Replay
+	};
+
+	~InputRecording() { Close(); }
+
+	// Opens or closes 'fileName' as needed, returns false (and stays off) if it can't be opened
+	bool SetMode(Mode mode, const char *fileName);
+	Mode GetMode() const { return m_Mode; }
+	bool IsRecording() const { return m_Mode == Mode_Record; }
+	bool IsReplaying() const { return m_Mode == Mode_Replay; }
+
+	// Call at the start of every frame. Recording writes out the previous frame and starts an empty one,
+	// replay reads the next frame. Returns false when the replay ran out of frames, it's switched off then.
+	bool NextFrame();
+
+	RecordedFrame &Frame() { return m_Frame; }
+	uint64_t FrameCount() const { return m_FrameCount; }
+
+	// OpenVR keeps action states constant between UpdateActionState calls, so only the first query of an action counts
+	void RecordDigitalAction(vr::VRActionHandle_t handle, bool state, bool changed);
+	void RecordAnalogAction(vr::VRActionHandle_t handle, bool valid, const vr::InputAnalogActionData_t &data);
+
+	// Actions the recorded frame doesn't know about read as inactive
+	void ReplayDigitalAction(vr::VRActionHandle_t handle, bool &state, bool &changed) const;
+	bool ReplayAnalogAction(vr::VRActionHandle_t handle, vr::InputAnalogActionData_t &data) const;
+
+private:
+	static constexpr uint32_t FILE_VERSION = 2;
+
+	bool WriteFrame();
+	bool ReadFrame();
+	void Close();
+
+	Mode m_Mode = Mode_Off;
+	FILE *m_File = nullptr;
+	RecordedFrame m_Frame;
+	bool m_HasFrame = false;
+	uint64_t m_FrameCount = 0;
+};
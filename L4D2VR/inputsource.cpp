@@ -0,0 +1,173 @@
+#include "inputsource.h"
+#include <algorithm>
+#include <iterator>
+
+namespace
+{
+	std::chrono::steady_clock::duration Seconds(float seconds)
+	{
+		return std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<float>(seconds));
+	}
+}
+
+void InputSource::Init(vr::IVRSystem *system, vr::IVRCompositor *compositor, vr::IVRInput *input)
+{
+	m_System = system;
+	m_Compositor = compositor;
+	m_Input = input;
+	m_VsyncToPhotons = m_System->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_SecondsFromVsyncToPhotons_Float);
+}
+
+void InputSource::BeginFrame(vr::VRActiveActionSet_t &actionSet)
+{
+	m_Latched = false;
+
+	if (m_Recording.IsReplaying() && m_Recording.NextFrame())
+	{
+		std::copy(std::begin(m_Recording.Frame().m_Poses), std::end(m_Recording.Frame().m_Poses), m_Poses);
+		return;
+	}
+
+	m_Compositor->WaitGetPoses(m_Poses, vr::k_unMaxTrackedDeviceCount, NULL, 0);
+	m_PosesTimestamp = std::chrono::steady_clock::now();
+	m_PosesPhotonTime = m_PosesTimestamp + Seconds(GetSecondsToPhotons());
+
+	m_Input->UpdateActionState(&actionSet, sizeof(vr::VRActiveActionSet_t), 1);
+
+	if (m_Recording.IsRecording() && m_Recording.NextFrame())
+	{
+		std::copy(std::begin(m_Poses), std::end(m_Poses), m_Recording.Frame().m_Poses);
+		m_Recording.Frame().m_PoseAge = -1.0f;
+	}
+}
+
+void InputSource::SamplePoses()
+{
+	// Same prediction WaitGetPoses does for the frame that's currently being rendered
+	const float secondsToPhotons = GetSecondsToPhotons();
+	m_System->GetDeviceToAbsoluteTrackingPose(m_Compositor->GetTrackingSpace(), secondsToPhotons, m_SampledPoses.m_Poses, vr::k_unMaxTrackedDeviceCount);
+
+	++m_SampledPoses.m_FrameIndex;
+	m_SampledPoses.m_Timestamp = std::chrono::steady_clock::now();
+	m_SampledPoses.m_PhotonTime = m_SampledPoses.m_Timestamp + Seconds(secondsToPhotons);
+	m_PoseBuffer.Publish(m_SampledPoses);
+}
+
+bool InputSource::LatchPoses()
+{
+	if (m_Recording.IsReplaying())
+	{
+		if (!m_Recording.Frame().m_Latched || m_Latched)
+			return false;
+
+		std::copy(std::begin(m_Recording.Frame().m_LatchedPoses), std::end(m_Recording.Frame().m_LatchedPoses), m_Poses);
+		m_Latched = true;
+		return true;
+	}
+
+	const uint64_t prevFrameIndex = m_LatchedPoses.m_FrameIndex;
+
+	if (!m_PoseBuffer.Read(m_LatchedPoses) || m_LatchedPoses.m_FrameIndex == prevFrameIndex || m_LatchedPoses.m_Timestamp <= m_PosesTimestamp)
+		return false;
+
+	std::copy(std::begin(m_LatchedPoses.m_Poses), std::end(m_LatchedPoses.m_Poses), m_Poses);
+	m_PosesTimestamp = m_LatchedPoses.m_Timestamp;
+	m_PosesPhotonTime = m_LatchedPoses.m_PhotonTime;
+
+	// Only the last latch of a frame is kept, that's the one the eyes were rendered with
+	if (m_Recording.IsRecording())
+	{
+		RecordedFrame &frame = m_Recording.Frame();
+		frame.m_Latched = true;
+		frame.m_LatchedPoseAge = -1.0f;
+		std::copy(std::begin(m_Poses), std::end(m_Poses), frame.m_LatchedPoses);
+	}
+
+	m_Latched = true;
+	return true;
+}
+
+float InputSource::GetPoseAge()
+{
+	RecordedFrame &frame = m_Recording.Frame();
+	float &recordedAge = m_Latched ? frame.m_LatchedPoseAge : frame.m_PoseAge;
+
+	if (m_Recording.IsReplaying())
+		return recordedAge;
+
+	const auto photonTime = std::chrono::steady_clock::now() + Seconds(GetSecondsToPhotons());
+	const float poseAge = std::max(std::chrono::duration<float>(photonTime - m_PosesPhotonTime).count(), 0.0f);
+
+	// The first query for a set of poses is the one the tracking code uses
+	if (m_Recording.IsRecording() && recordedAge < 0)
+		recordedAge = poseAge;
+
+	return poseAge;
+}
+
+// The compositor's frame time remaining already accounts for running start, unlike the time since the last vsync
+float InputSource::GetSecondsToPhotons()
+{
+	return m_Compositor->GetFrameTimeRemaining() + m_VsyncToPhotons;
+}
+
+void InputSource::GetControllerIndices(vr::TrackedDeviceIndex_t &left, vr::TrackedDeviceIndex_t &right)
+{
+	if (m_Recording.IsReplaying())
+	{
+		left = m_Recording.Frame().m_LeftController;
+		right = m_Recording.Frame().m_RightController;
+		return;
+	}
+
+	left = m_System->GetTrackedDeviceIndexForControllerRole(vr::TrackedControllerRole_LeftHand);
+	right = m_System->GetTrackedDeviceIndexForControllerRole(vr::TrackedControllerRole_RightHand);
+
+	if (m_Recording.IsRecording())
+	{
+		m_Recording.Frame().m_LeftController = left;
+		m_Recording.Frame().m_RightController = right;
+	}
+}
+
+void InputSource::GetDigitalAction(vr::VRActionHandle_t handle, bool &state, bool &changed)
+{
+	if (m_Recording.IsReplaying())
+	{
+		m_Recording.ReplayDigitalAction(handle, state, changed);
+		return;
+	}
+
+	vr::InputDigitalActionData_t digitalActionData;
+	const bool valid = m_Input->GetDigitalActionData(handle, &digitalActionData, sizeof(digitalActionData), vr::k_ulInvalidInputValueHandle) == vr::VRInputError_None;
+
+	state = valid && digitalActionData.bState;
+	changed = valid && digitalActionData.bChanged;
+
+	if (m_Recording.IsRecording())
+		m_Recording.RecordDigitalAction(handle, state, changed);
+}
+
+bool InputSource::GetAnalogAction(vr::VRActionHandle_t handle, vr::InputAnalogActionData_t &data)
+{
+	if (m_Recording.IsReplaying())
+		return m_Recording.ReplayAnalogAction(handle, data);
+
+	const bool valid = m_Input->GetAnalogActionData(handle, &data, sizeof(data), vr::k_ulInvalidInputValueHandle) == vr::VRInputError_None;
+
+	if (m_Recording.IsRecording())
+		m_Recording.RecordAnalogAction(handle, valid, data);
+
+	return valid;
+}
+
+float InputSource::GetFrameDelta(float measured)
+{
+	if (m_Recording.IsReplaying())
+		return m_Recording.Frame().m_FrameDelta;
+
+	if (m_Recording.IsRecording())
+		m_Recording.Frame().m_FrameDelta = measured;
+
+	return measured;
+}
@@ -0,0 +1,73 @@
+#pragma once
+#include "openvr.h"
+#include "inputrecording.h"
+#include "posebuffer.h"
+#include <chrono>
+
+// HMD and controller poses sampled by the tracking thread, predicted to when the frame being rendered at
+// the time of sampling reaches the display
+struct PoseSnapshot
+{
+	uint64_t m_FrameIndex = 0;
+	std::chrono::steady_clock::time_point m_Timestamp;
+	std::chrono::steady_clock::time_point m_PhotonTime; // What the poses were predicted for
+	vr::TrackedDevicePose_t m_Poses[vr::k_unMaxTrackedDeviceCount];
+};
+
+// Where VR gets its poses and actions from: OpenVR through the interfaces handed to Init(), or a recording that's
+// being replayed. Also records everything it reads while the recording is recording. Doesn't reach OpenVR any
+// other way, so it runs against mock interfaces without a headset, see tests/inputsource_test.cpp.
+class InputSource
+{
+public:
+	void Init(vr::IVRSystem *system, vr::IVRCompositor *compositor, vr::IVRInput *input);
+
+	InputRecording &Recording() { return m_Recording; }
+
+	// Called once per frame on the render thread: WaitGetPoses and the action state, or the next recorded frame.
+	// Always on the render thread, every WaitGetPoses has to be paired with the Submit of the same frame, and under
+	// Vulkan it uses the queue dxvk submits to.
+	void BeginFrame(vr::VRActiveActionSet_t &actionSet);
+
+	// Called by the tracking thread. Samples the poses for the frame that's currently being rendered and publishes
+	// them for LatchPoses(), only reads tracking state, so neither frame pacing nor dxvk's queue are touched.
+	void SamplePoses();
+
+	// Swaps in the newest sampled poses. Returns false if they aren't newer than the current ones.
+	// Replay swaps in the poses the recorded frame latched instead.
+	bool LatchPoses();
+
+	const vr::TrackedDevicePose_t &Pose(vr::TrackedDeviceIndex_t index) const { return m_Poses[index]; }
+
+	// How much later than the current poses were predicted for the photons of the frame being rendered now are
+	float GetPoseAge();
+
+	// How far the photons of the frame being rendered right now are from now
+	float GetSecondsToPhotons();
+
+	void GetControllerIndices(vr::TrackedDeviceIndex_t &left, vr::TrackedDeviceIndex_t &right);
+
+	// Actions that can't be read are inactive. GetAnalogAction returns false for them.
+	void GetDigitalAction(vr::VRActionHandle_t handle, bool &state, bool &changed);
+	bool GetAnalogAction(vr::VRActionHandle_t handle, vr::InputAnalogActionData_t &data);
+
+	// Replaces 'measured' (seconds since the previous ProcessInput) with the recorded one during replay
+	float GetFrameDelta(float measured);
+
+private:
+	vr::IVRSystem *m_System = nullptr;
+	vr::IVRCompositor *m_Compositor = nullptr;
+	vr::IVRInput *m_Input = nullptr;
+	float m_VsyncToPhotons = 0.0f; // Seconds between the HMD's vsync and its pixels lighting up
+
+	InputRecording m_Recording;
+
+	vr::TrackedDevicePose_t m_Poses[vr::k_unMaxTrackedDeviceCount] = {};
+	std::chrono::steady_clock::time_point m_PosesTimestamp; // When m_Poses were fetched from the compositor
+	std::chrono::steady_clock::time_point m_PosesPhotonTime; // When the frame m_Poses were predicted for reaches the display
+	bool m_Latched = false; // m_Poses came from LatchPoses() this frame
+
+	SeqLockTripleBuffer<PoseSnapshot> m_PoseBuffer;
+	PoseSnapshot m_SampledPoses; // Only touched by the tracking thread
+	PoseSnapshot m_LatchedPoses;
+};
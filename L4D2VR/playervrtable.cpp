@@ -0,0 +1,96 @@
+#include "playervrtable.h"
+
+PlayerVRTable::PlayerVRTable()
+{
+	for (int i = 0; i < MAX_PLAYERS; ++i)
+	{
+		m_ControllerPos[i].Init(0, 0, 0);
+		m_FireControllerPos[i].Init(0, 0, 0);
+		m_ControllerAngle[i].Init(0, 0, 0);
+		m_FireControllerAngle[i].Init(0, 0, 0);
+		m_LeftControllerPos[i].Init(0, 0, 0);
+		m_LeftControllerAngle[i].Init(0, 0, 0);
+		m_HmdPos[i].Init(0, 0, 0);
+		m_HmdAngle[i].Init(0, 0, 0);
+		m_FireTick[i] = -1;
+		m_RunTick[i] = -1;
+	}
+}
+
+void PlayerVRTable::SetUsingVR(int slot, bool usingVR)
+{
+	if (usingVR)
+	{
+		m_ActiveMask |= 1u << slot;
+		return;
+	}
+
+	m_ActiveMask &= ~(1u << slot);
+	m_PoseHistory[slot].Clear();
+	m_UsercmdHistory[slot].Clear();
+	m_FireTick[slot] = -1;
+}
+
+void PlayerVRTable::AddUsercmd(int slot, int tick, bool firing)
+{
+	m_PoseHistory[slot].Add(tick, m_ControllerPos[slot], m_ControllerAngle[slot]);
+
+	// Held fire buttons keep firing, so any command that has one down may be the one a shot comes from,
+	// not just the one that pressed it. Resent commands are older than the ones already seen.
+	if (firing && tick > m_FireTick[slot])
+		m_FireTick[slot] = tick;
+}
+
+void PlayerVRTable::BeginFire(int slot)
+{
+	m_FiringMask |= 1u << slot;
+
+	const int fireTick = m_RunTick[slot] >= 0 ? m_RunTick[slot] : m_FireTick[slot];
+	const VRPoseHistory &history = m_PoseHistory[slot];
+
+	if (fireTick < 0 || history.IsEmpty() || fireTick < history.OldestTick()
+		|| !history.Sample((float)fireTick, m_FireControllerPos[slot], m_FireControllerAngle[slot]))
+	{
+		m_FireControllerPos[slot] = m_ControllerPos[slot];
+		m_FireControllerAngle[slot] = m_ControllerAngle[slot];
+	}
+}
+
+void PlayerVRTable::MapEntity(const void *entity, int slot)
+{
+	for (int attempt = 0; attempt < 2; ++attempt)
+	{
+		for (uint32_t i = 0, index = HashEntity(entity); i < HASH_SIZE; ++i, index = (index + 1) & (HASH_SIZE - 1))
+		{
+			if (!m_HashEntities[index] || m_HashEntities[index] == entity)
+			{
+				m_HashEntities[index] = entity;
+				m_HashSlots[index] = (int8_t)slot;
+				return;
+			}
+		}
+
+		// Only fills up with pointers of players that left long ago, start over
+		ClearEntityMap();
+	}
+}
+
+void PlayerVRTable::ClearEntityMap()
+{
+	for (const void *&hashEntity : m_HashEntities)
+		hashEntity = nullptr;
+}
+
+int PlayerVRTable::FindSlot(const void *entity) const
+{
+	for (uint32_t i = 0, index = HashEntity(entity); i < HASH_SIZE; ++i, index = (index + 1) & (HASH_SIZE - 1))
+	{
+		if (m_HashEntities[index] == entity)
+			return m_HashSlots[index];
+
+		if (!m_HashEntities[index])
+			break;
+	}
+
+	return -1;
+}
@@ -0,0 +1,71 @@
+#pragma once
+#include "vector.h"
+#include "vrusercmd.h"
+#include "vrposehistory.h"
+#include <cstdint>
+
+// Server side VR state of every player, indexed by entity index. Laid out as separate arrays so the aim hooks,
+// which run many times per tick, only pull in the pose they need and the mask instead of a whole player.
+class PlayerVRTable
+{
+public:
+	static constexpr int MAX_PLAYERS = 24;
+
+	// Hot, read by the aim hooks
+	uint32_t m_ActiveMask = 0;	// Bit per slot whose last usercmd carried VR data
+	uint32_t m_FiringMask = 0;	// Bit per slot that's inside CWeaponPortalgun::FirePortal
+	VectorAligned m_ControllerPos[MAX_PLAYERS];
+	VectorAligned m_FireControllerPos[MAX_PLAYERS];
+	QAngle m_ControllerAngle[MAX_PLAYERS];
+	QAngle m_FireControllerAngle[MAX_PLAYERS];
+
+	// Cold, only touched when usercmds come in
+	Vector m_LeftControllerPos[MAX_PLAYERS];
+	QAngle m_LeftControllerAngle[MAX_PLAYERS];
+	Vector m_HmdPos[MAX_PLAYERS];
+	QAngle m_HmdAngle[MAX_PLAYERS];
+	int m_FireTick[MAX_PLAYERS];	// tick_count of the newest command with a fire button down
+	int m_RunTick[MAX_PLAYERS];		// tick_count of the command the server is simulating, -1 between commands
+	VRUsercmdHistory m_UsercmdHistory[MAX_PLAYERS];
+	VRPoseHistory m_PoseHistory[MAX_PLAYERS];
+
+	PlayerVRTable();
+
+	static bool IsValidSlot(int slot) { return (unsigned)slot < MAX_PLAYERS; }
+	bool IsUsingVR(int slot) const { return IsValidSlot(slot) && (m_ActiveMask & (1u << slot)); }
+	void SetUsingVR(int slot, bool usingVR);
+
+	// Called for every usercmd of a VR player whose poses were decoded, after they were stored
+	void AddUsercmd(int slot, int tick, bool firing);
+
+	// Around PlayerRunCommand. The server reads every command in a packet before it simulates any of them,
+	// so the newest command read is usually not the one being simulated.
+	void BeginCommand(int slot, int tick) { m_RunTick[slot] = tick; }
+	void EndCommand(int slot) { m_RunTick[slot] = -1; }
+
+	// While a shot is being fired aim with the pose from the command being simulated, the latest pose
+	// may be several ticks newer. Outside of a command, the newest one with a fire button down.
+	void BeginFire(int slot);
+	void EndFire(int slot) { m_FiringMask &= ~(1u << slot); }
+
+	const Vector &AimControllerPos(int slot) const { return (m_FiringMask & (1u << slot)) ? m_FireControllerPos[slot] : m_ControllerPos[slot]; }
+	QAngle &AimControllerAngle(int slot) { return (m_FiringMask & (1u << slot)) ? m_FireControllerAngle[slot] : m_ControllerAngle[slot]; }
+
+	// Entity pointer to slot cache, saves calling into the server for CBaseEntity::entindex on every lookup.
+	// FindSlot returns -1 for entities it hasn't seen.
+	void MapEntity(const void *entity, int slot);
+	int FindSlot(const void *entity) const;
+	void ClearEntityMap();
+
+private:
+	static constexpr int HASH_SIZE = 64; // Power of two, comfortably more than MAX_PLAYERS
+
+	static uint32_t HashEntity(const void *entity)
+	{
+		// Entities are at least 16 byte aligned, Fibonacci hashing spreads the rest over the table
+		return ((uint32_t)((uintptr_t)entity >> 4) * 2654435769u) >> 26;
+	}
+
+	const void *m_HashEntities[HASH_SIZE] = {};
+	int8_t m_HashSlots[HASH_SIZE] = {};
+};
@@ -0,0 +1,66 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <type_traits>
+
+// Single producer, multiple consumer snapshot buffer. The writer never waits on readers and
+// readers never take a lock: every slot carries a sequence counter that is odd while it's
+// being written, readers retry in the (rare) case the writer lapped them mid-copy.
+// Three slots mean the writer always has a slot that isn't the one readers were just sent to.
+template <typename T>
+class SeqLockTripleBuffer
+{
+	static_assert(std::is_trivially_copyable_v<T>, "SeqLockTripleBuffer needs a trivially copyable type");
+
+public:
+	// Must only be called from a single thread
+	void Publish(const T &value)
+	{
+		const uint32_t index = (m_Latest.load(std::memory_order_relaxed) + 1) % 3;
+		Slot &slot = m_Slots[index];
+
+		const uint32_t sequence = slot.sequence.load(std::memory_order_relaxed);
+		slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+		std::atomic_thread_fence(std::memory_order_release);
+
+		memcpy(&slot.value, &value, sizeof(T));
+
+		slot.sequence.store(sequence + 2, std::memory_order_release);
+		m_Latest.store(index, std::memory_order_release);
+		m_HasValue.store(true, std::memory_order_release);
+	}
+
+	// Copies the most recently published value into 'out', returns false if nothing was published yet
+	bool Read(T &out) const
+	{
+		if (!m_HasValue.load(std::memory_order_acquire))
+			return false;
+
+		while (true)
+		{
+			const Slot &slot = m_Slots[m_Latest.load(std::memory_order_acquire)];
+
+			const uint32_t sequence = slot.sequence.load(std::memory_order_acquire);
+			if (sequence & 1)
+				continue;
+
+			memcpy(&out, &slot.value, sizeof(T));
+			std::atomic_thread_fence(std::memory_order_acquire);
+
+			if (slot.sequence.load(std::memory_order_relaxed) == sequence)
+				return true;
+		}
+	}
+
+private:
+	struct Slot
+	{
+		std::atomic<uint32_t> sequence = 0;
+		T value;
+	};
+
+	Slot m_Slots[3];
+	std::atomic<uint32_t> m_Latest = 0;
+	std::atomic<bool> m_HasValue = false;
+};
@@ -0,0 +1,45 @@
+#include "prediction.h"
+#include <cmath>
+
+vr::TrackedDevicePose_t PredictPose(const vr::TrackedDevicePose_t &pose, float seconds)
+{
+	if (!pose.bPoseIsValid || seconds == 0.0f)
+		return pose;
+
+	vr::TrackedDevicePose_t predicted = pose;
+	const vr::HmdMatrix34_t &mat = pose.mDeviceToAbsoluteTracking;
+	vr::HmdMatrix34_t &out = predicted.mDeviceToAbsoluteTracking;
+
+	const float *angVel = pose.vAngularVelocity.v;
+	const float angSpeed = sqrtf(angVel[0] * angVel[0] + angVel[1] * angVel[1] + angVel[2] * angVel[2]);
+	const float angle = angSpeed * seconds;
+
+	if (fabsf(angle) > 1e-6f)
+	{
+		// Rotation of 'angle' around the angular velocity axis
+		const float s = sinf(angle * 0.5f) / angSpeed;
+		const float qw = cosf(angle * 0.5f);
+		const float qx = angVel[0] * s;
+		const float qy = angVel[1] * s;
+		const float qz = angVel[2] * s;
+
+		const float rot[3][3] =
+		{
+			{ 1 - 2 * (qy * qy + qz * qz), 2 * (qx * qy - qz * qw),     2 * (qx * qz + qy * qw) },
+			{ 2 * (qx * qy + qz * qw),     1 - 2 * (qx * qx + qz * qz), 2 * (qy * qz - qx * qw) },
+			{ 2 * (qx * qz - qy * qw),     2 * (qy * qz + qx * qw),     1 - 2 * (qx * qx + qy * qy) }
+		};
+
+		// Angular velocity is in tracking space, so the delta rotation is applied on the left
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int col = 0; col < 3; ++col)
+				out.m[row][col] = rot[row][0] * mat.m[0][col] + rot[row][1] * mat.m[1][col] + rot[row][2] * mat.m[2][col];
+		}
+	}
+
+	for (int i = 0; i < 3; ++i)
+		out.m[i][3] = mat.m[i][3] + pose.vVelocity.v[i] * seconds;
+
+	return predicted;
+}
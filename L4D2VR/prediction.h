@@ -0,0 +1,9 @@
+#pragma once
+#include "openvr.h"
+
+// Upper bound for any prediction horizon, extrapolating further than this only adds error
+constexpr float MAX_PREDICTION_SECONDS = 0.1f;
+
+// Extrapolates 'pose' by 'seconds' using its linear and angular velocity (both in tracking space).
+// The rotation is integrated as a quaternion, which is exact for a constant angular velocity.
+vr::TrackedDevicePose_t PredictPose(const vr::TrackedDevicePose_t &pose, float seconds);
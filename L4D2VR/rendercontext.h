@@ -0,0 +1,46 @@
+#pragma once
+#include "sdk.h"
+#include "frametiming.h"
+
+// Borrows the material system's render context for the lifetime of the scope. The outermost scope on a
+// thread acquires it (GetRenderContext + BeginRender), every scope opened while it's alive, e.g. by the
+// hooks the original RenderView calls into, reuses the cached pointer without a virtual call. The context
+// is released again when the outermost scope closes.
+class RenderContextScope
+{
+public:
+	explicit RenderContextScope(IMaterialSystem *materialSystem)
+	{
+		if (s_Depth++ > 0)
+		{
+			FrameTiming::Count(Counter_RenderContextReuse);
+			return;
+		}
+
+		m_Owned = materialSystem->GetRenderContext();
+		s_Context = m_Owned;
+		FrameTiming::Count(Counter_RenderContextAcquire);
+	}
+
+	~RenderContextScope()
+	{
+		if (--s_Depth > 0)
+			return;
+
+		s_Context = nullptr;
+		m_Owned.SafeRelease();
+		FrameTiming::Count(Counter_RenderContextRelease);
+	}
+
+	RenderContextScope(const RenderContextScope &) = delete;
+	RenderContextScope &operator=(const RenderContextScope &) = delete;
+
+	IMatRenderContext *operator->() const { return s_Context; }
+	IMatRenderContext *Get() const { return s_Context; }
+
+private:
+	static inline thread_local IMatRenderContext *s_Context = nullptr;
+	static inline thread_local int s_Depth = 0;
+
+	CMatRenderContextPtr m_Owned;	// Only set in the outermost scope
+};
@@ -0,0 +1,71 @@
+#include "rendertargetpool.h"
+#include <d3d9.h>
+#include <algorithm>
+#include <iostream>
+
+const PooledRenderTarget *RenderTargetPool::Find(const RenderTargetKey &key) const
+{
+	auto it = m_Targets.find(key.m_Name);
+	if (it == m_Targets.end() || !(it->second.m_Key == key))
+		return nullptr;
+
+	const PooledRenderTarget &target = it->second;
+	if (!target.m_Surface || IsOrphaned(target.m_Surface) || (target.m_DepthSurface && IsOrphaned(target.m_DepthSurface)))
+		return nullptr;
+
+	return &target;
+}
+
+const PooledRenderTarget &RenderTargetPool::Store(PooledRenderTarget target)
+{
+	PooledRenderTarget &pooled = m_Targets[target.m_Key.m_Name];
+
+	// dxvk only captures surfaces it actually created, if the material system handed back the existing
+	// texture the pooled surfaces still belong to it
+	if (!target.m_Surface && pooled.m_Texture == target.m_Texture)
+	{
+		pooled.m_Key = target.m_Key;
+		return pooled;
+	}
+
+	if (pooled.m_Surface)
+		std::cout << "Reallocated VR render target " << target.m_Key.m_Name << "\n";
+
+	Release(pooled);
+	pooled = target;
+	return pooled;
+}
+
+void RenderTargetPool::Retain(const std::vector<RenderTargetKey> &keys)
+{
+	for (auto it = m_Targets.begin(); it != m_Targets.end();)
+	{
+		if (std::none_of(keys.begin(), keys.end(), [&](const RenderTargetKey &key) { return key.m_Name == it->first; }))
+		{
+			Release(it->second);
+			it = m_Targets.erase(it);
+		}
+		else
+		{
+			++it;
+		}
+	}
+}
+
+// The pool holds one reference, anything beyond that is the material system still using the texture
+bool RenderTargetPool::IsOrphaned(IDirect3DSurface9 *surface)
+{
+	surface->AddRef();
+	return surface->Release() <= 1;
+}
+
+void RenderTargetPool::Release(PooledRenderTarget &target)
+{
+	if (target.m_Surface)
+		target.m_Surface->Release();
+	if (target.m_DepthSurface)
+		target.m_DepthSurface->Release();
+
+	target.m_Surface = nullptr;
+	target.m_DepthSurface = nullptr;
+}
@@ -0,0 +1,64 @@
+#pragma once
+#include "sharedtexture.h"
+#include <cstdint>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class ITexture;
+class IDirect3DSurface9;
+
+// What a VR render target was created with, a pooled target is only handed out again for the same parameters
+struct RenderTargetKey
+{
+	std::string m_Name;
+	int m_Width = 0;
+	int m_Height = 0;
+	int m_Format = 0;				// ImageFormat
+	int m_Depth = 0;				// MaterialRenderTargetDepth_t
+	uint32_t m_AntiAliasing = 0;	// dxvk multisamples the eye textures while creating them
+	bool m_ShareDepth = false;		// dxvk creates the depth buffer so it can be submitted to the compositor
+
+	bool operator==(const RenderTargetKey &other) const
+	{
+		return m_Name == other.m_Name && m_Width == other.m_Width && m_Height == other.m_Height && m_Format == other.m_Format
+			&& m_Depth == other.m_Depth && m_AntiAliasing == other.m_AntiAliasing && m_ShareDepth == other.m_ShareDepth;
+	}
+};
+
+// A render target along with the surfaces dxvk captured while creating it. The pool holds the
+// references dxvk took on the surfaces, so they're released once the target is replaced.
+struct PooledRenderTarget
+{
+	RenderTargetKey m_Key;
+	ITexture *m_Texture = nullptr;
+	IDirect3DSurface9 *m_Surface = nullptr;
+	IDirect3DSurface9 *m_DepthSurface = nullptr;	// Only for m_ShareDepth
+	SharedTextureHolder m_SharedTexture;
+	SharedTextureHolder m_SharedDepth;
+};
+
+// Keeps the VR render targets across VR::CreateVRTextures calls. Every allocation cycle makes Source flush and
+// reallocate all of its render targets, so CreateVRTextures only goes through one when a target is missing,
+// was asked for with different parameters, or was dropped by the material system (e.g. on a device reset).
+class RenderTargetPool
+{
+public:
+	// The target pooled under key.m_Name, if it was created the same way and the material system still uses it
+	const PooledRenderTarget *Find(const RenderTargetKey &key) const;
+
+	// Pools a newly created target in place of whatever was pooled under its name. References to pooled targets
+	// stay valid until their name is stored again or released.
+	const PooledRenderTarget &Store(PooledRenderTarget target);
+
+	// Releases every target that isn't in 'keys', e.g. eye texture sets that are no longer used
+	void Retain(const std::vector<RenderTargetKey> &keys);
+
+	size_t Size() const { return m_Targets.size(); }
+
+private:
+	static bool IsOrphaned(IDirect3DSurface9 *surface);
+	static void Release(PooledRenderTarget &target);
+
+	std::unordered_map<std::string, PooledRenderTarget> m_Targets;
+};
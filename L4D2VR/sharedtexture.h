@@ -0,0 +1,20 @@
+#pragma once
+#include "openvr.h"
+
+struct SharedTextureHolder 
+{
+	vr::VRVulkanTextureData_t m_VulkanData;
+	vr::Texture_t m_VRTexture;
+
+	SharedTextureHolder() = default;
+	SharedTextureHolder(const SharedTextureHolder &other) { *this = other; }
+
+	// m_VRTexture.handle points at our own m_VulkanData, keep it that way for copies
+	SharedTextureHolder &operator=(const SharedTextureHolder &other)
+	{
+		m_VulkanData = other.m_VulkanData;
+		m_VRTexture = other.m_VRTexture;
+		m_VRTexture.handle = &m_VulkanData;
+		return *this;
+	}
+};
@@ -0,0 +1,277 @@
+#pragma once
+#include "sigscanner.h"
+#include <emmintrin.h>
+#include <immintrin.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <iterator>
+#include <thread>
+
+// The part of the signature scanner that only looks at bytes: the anchor pre-filter and the masked compare.
+// Kept free of Win32 so it can be benchmarked on its own, see tests/sigscan_benchmark.cpp.
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#define SIGMATCH_TARGET_AVX2
+#else
+#define SIGMATCH_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+
+namespace SigMatch
+{
+	// Patterns that share the same anchor byte, so each distinct anchor only gets compared once per block
+	struct AnchorBucket
+	{
+		uint8_t byte;
+		uint8_t first;		// into PatternScan::patterns
+		uint8_t count;
+	};
+
+	// Every signature looked for in one byte span
+	struct PatternScan
+	{
+		const uint8_t *base = nullptr;
+		size_t size = 0;
+
+		// Sorted by anchor byte by Prepare()
+		const Signature *patterns[SignatureSet::MAX_ENTRIES];
+		uint8_t tags[SignatureSet::MAX_ENTRIES];			// Caller's index for each pattern, moves along with it
+		size_t numPatterns = 0;
+
+		AnchorBucket buckets[SignatureSet::MAX_ENTRIES];
+		size_t numBuckets = 0;
+		size_t maxAnchor = 0;
+
+		std::atomic<int64_t> found[SignatureSet::MAX_ENTRIES];	// Lowest match per pattern, INT64_MAX if none
+
+		void Reset(const uint8_t *spanBase, size_t spanSize)
+		{
+			base = spanBase;
+			size = spanSize;
+			numPatterns = 0;
+			numBuckets = 0;
+			maxAnchor = 0;
+		}
+
+		bool Add(const Signature *sig, uint8_t tag)
+		{
+			if (numPatterns == SignatureSet::MAX_ENTRIES)
+				return false;
+
+			patterns[numPatterns] = sig;
+			tags[numPatterns++] = tag;
+			return true;
+		}
+	};
+
+	inline bool MatchesAt(const uint8_t *base, size_t size, int64_t offset, const Signature &sig)
+	{
+		if (offset < 0 || offset + sig.length > (int64_t)size)
+			return false;
+
+		const uint8_t *data = base + offset;
+		for (size_t i = 0; i < sig.length; ++i)
+		{
+			if ((data[i] & sig.mask[i]) != sig.bytes[i])
+				return false;
+		}
+		return true;
+	}
+
+	inline unsigned LowestBit(uint32_t bits)
+	{
+#if defined(_MSC_VER) && !defined(__clang__)
+		unsigned long bit;
+		_BitScanForward(&bit, bits);
+		return bit;
+#else
+		return (unsigned)__builtin_ctz(bits);
+#endif
+	}
+
+	struct CompareSSE2
+	{
+		static constexpr size_t BLOCK_SIZE = 16;
+
+		uint32_t operator()(const uint8_t *data, uint8_t anchor) const
+		{
+			const __m128i block = _mm_loadu_si128((const __m128i *)data);
+			return (uint32_t)_mm_movemask_epi8(_mm_cmpeq_epi8(block, _mm_set1_epi8((char)anchor)));
+		}
+	};
+
+	struct CompareAVX2
+	{
+		static constexpr size_t BLOCK_SIZE = 32;
+
+		SIGMATCH_TARGET_AVX2 uint32_t operator()(const uint8_t *data, uint8_t anchor) const
+		{
+			const __m256i block = _mm256_loadu_si256((const __m256i *)data);
+			return (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(block, _mm256_set1_epi8((char)anchor)));
+		}
+	};
+
+	// Groups the patterns by anchor byte, must be called once before scanning
+	inline void Prepare(PatternScan &scan)
+	{
+		size_t order[SignatureSet::MAX_ENTRIES];
+		for (size_t p = 0; p < scan.numPatterns; ++p)
+			order[p] = p;
+
+		std::sort(order, order + scan.numPatterns, [&](size_t a, size_t b)
+		{
+			return scan.patterns[a]->bytes[scan.patterns[a]->anchor] < scan.patterns[b]->bytes[scan.patterns[b]->anchor];
+		});
+
+		const Signature *patterns[SignatureSet::MAX_ENTRIES];
+		uint8_t tags[SignatureSet::MAX_ENTRIES];
+		for (size_t p = 0; p < scan.numPatterns; ++p)
+		{
+			patterns[p] = scan.patterns[order[p]];
+			tags[p] = scan.tags[order[p]];
+		}
+
+		scan.numBuckets = 0;
+		scan.maxAnchor = 0;
+		for (size_t p = 0; p < scan.numPatterns; ++p)
+		{
+			scan.patterns[p] = patterns[p];
+			scan.tags[p] = tags[p];
+
+			const Signature &sig = *patterns[p];
+			const uint8_t anchorByte = sig.bytes[sig.anchor];
+			scan.maxAnchor = std::max(scan.maxAnchor, (size_t)sig.anchor);
+
+			if (scan.numBuckets == 0 || scan.buckets[scan.numBuckets - 1].byte != anchorByte)
+				scan.buckets[scan.numBuckets++] = { anchorByte, (uint8_t)p, 0 };
+			++scan.buckets[scan.numBuckets - 1].count;
+
+			scan.found[p].store(INT64_MAX);
+		}
+	}
+
+	// Scans all pattern start positions in [chunkBegin, chunkEnd). Each block of data is loaded once and
+	// compared against every distinct anchor byte still looked for, candidates are then fully verified.
+	template <typename CompareBlock>
+	void ScanChunk(PatternScan &scan, size_t chunkBegin, size_t chunkEnd, CompareBlock compareBlock)
+	{
+		bool done[SignatureSet::MAX_ENTRIES];
+		uint8_t bucketRemaining[SignatureSet::MAX_ENTRIES];
+		size_t remaining = 0;
+
+		for (size_t b = 0; b < scan.numBuckets; ++b)
+		{
+			const AnchorBucket &bucket = scan.buckets[b];
+			bucketRemaining[b] = 0;
+
+			for (size_t p = bucket.first; p < bucket.first + bucket.count; ++p)
+			{
+				// Skip patterns that already matched at a lower offset in another chunk
+				done[p] = scan.found[p].load(std::memory_order_relaxed) < (int64_t)chunkBegin;
+				if (!done[p])
+				{
+					++bucketRemaining[b];
+					++remaining;
+				}
+			}
+		}
+
+		const auto checkCandidates = [&](size_t bucketIndex, size_t dataPos)
+		{
+			const AnchorBucket &bucket = scan.buckets[bucketIndex];
+
+			for (size_t p = bucket.first; p < bucket.first + bucket.count; ++p)
+			{
+				const Signature &sig = *scan.patterns[p];
+				if (done[p] || dataPos < sig.anchor)
+					continue;
+
+				const size_t start = dataPos - sig.anchor;
+				if (start < chunkBegin || start >= chunkEnd || !MatchesAt(scan.base, scan.size, start, sig))
+					continue;
+
+				int64_t current = scan.found[p].load(std::memory_order_relaxed);
+				while ((int64_t)start < current && !scan.found[p].compare_exchange_weak(current, start))
+					;
+
+				// Scanning in ascending order, so the first match in a chunk is the lowest one
+				done[p] = true;
+				--bucketRemaining[bucketIndex];
+				--remaining;
+			}
+		};
+
+		// Data positions needed to cover every pattern start inside this chunk
+		const size_t blockSize = CompareBlock::BLOCK_SIZE;
+		const size_t dataEnd = std::min(chunkEnd + scan.maxAnchor, scan.size);
+		size_t pos = chunkBegin;
+
+		for (; pos + blockSize <= dataEnd && remaining; pos += blockSize)
+		{
+			for (size_t b = 0; b < scan.numBuckets; ++b)
+			{
+				if (!bucketRemaining[b])
+					continue;
+
+				uint32_t bits = compareBlock(scan.base + pos, scan.buckets[b].byte);
+				while (bits && bucketRemaining[b])
+				{
+					const unsigned bit = LowestBit(bits);
+					bits &= bits - 1;
+					checkCandidates(b, pos + bit);
+				}
+			}
+		}
+
+		for (; pos < dataEnd && remaining; ++pos)
+		{
+			for (size_t b = 0; b < scan.numBuckets; ++b)
+			{
+				if (bucketRemaining[b] && scan.base[pos] == scan.buckets[b].byte)
+					checkCandidates(b, pos);
+			}
+		}
+	}
+
+	SIGMATCH_TARGET_AVX2 inline void ScanChunkAVX2(PatternScan &scan, size_t chunkBegin, size_t chunkEnd)
+	{
+		ScanChunk(scan, chunkBegin, chunkEnd, CompareAVX2());
+	}
+
+	// Finds the lowest match of every pattern, split into chunks across worker threads.
+	// numWorkers = 0 uses one per hardware thread.
+	inline void Scan(PatternScan &scan, bool useAVX2, size_t numWorkers = 0)
+	{
+		if (numWorkers == 0)
+			numWorkers = std::max(1u, std::thread::hardware_concurrency());
+
+		const size_t chunkSize = std::max<size_t>(256 * 1024, scan.size / (numWorkers * 4) + 1);
+		const size_t numChunks = (scan.size + chunkSize - 1) / chunkSize;
+
+		std::atomic<size_t> nextChunk = 0;
+		const auto worker = [&]()
+		{
+			size_t chunk;
+			while ((chunk = nextChunk.fetch_add(1)) < numChunks)
+			{
+				const size_t chunkBegin = chunk * chunkSize;
+				const size_t chunkEnd = std::min(chunkBegin + chunkSize, scan.size);
+
+				if (useAVX2)
+					ScanChunkAVX2(scan, chunkBegin, chunkEnd);
+				else
+					ScanChunk(scan, chunkBegin, chunkEnd, CompareSSE2());
+			}
+		};
+
+		std::thread threads[64];
+		const size_t numThreads = std::min({ numWorkers, numChunks, std::size(threads) + 1 });
+		for (size_t i = 1; i < numThreads; ++i)
+			threads[i - 1] = std::thread(worker);
+		worker();
+
+		for (size_t i = 1; i < numThreads; ++i)
+			threads[i - 1].join();
+	}
+}
@@ -0,0 +1,247 @@
+#include "sigscanner.h"
+#include "sigmatch.h"
+#include <Windows.h>
+#include <psapi.h>
+#include <intrin.h>
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <chrono>
+
+namespace
+{
+	constexpr size_t MAX_MODULES = 16;
+	constexpr size_t MAX_MODULE_NAME = 64;
+
+	struct ModuleImage
+	{
+		const uint8_t *base = nullptr;
+		size_t size = 0;
+		uint32_t timestamp = 0;
+	};
+
+	struct ModuleScan
+	{
+		const char *moduleName = nullptr;
+		ModuleImage image;
+		SigMatch::PatternScan scan;		// Tagged with indices into the SignatureSet
+	};
+
+	struct CacheEntry
+	{
+		char moduleName[MAX_MODULE_NAME];
+		uint32_t size;
+		uint32_t timestamp;
+		uint32_t hash;
+		int offset;
+	};
+
+	bool CpuSupportsAVX2()
+	{
+		int info[4];
+		__cpuid(info, 0);
+		if (info[0] < 7)
+			return false;
+
+		__cpuid(info, 1);
+		const bool osxsave = (info[2] & (1 << 27)) != 0;
+		const bool avx = (info[2] & (1 << 28)) != 0;
+		if (!osxsave || !avx || (_xgetbv(0) & 6) != 6)
+			return false;
+
+		__cpuidex(info, 7, 0);
+		return (info[1] & (1 << 5)) != 0;
+	}
+
+	bool GetModuleImage(const char *moduleName, ModuleImage &out)
+	{
+		HMODULE hModule = GetModuleHandle(moduleName);
+		if (!hModule)
+			return false;
+
+		MODULEINFO moduleInfo;
+		if (!GetModuleInformation(GetCurrentProcess(), hModule, &moduleInfo, sizeof(moduleInfo)))
+			return false;
+
+		const IMAGE_DOS_HEADER *dosHeader = (const IMAGE_DOS_HEADER *)hModule;
+		const IMAGE_NT_HEADERS *ntHeaders = (const IMAGE_NT_HEADERS *)((const uint8_t *)hModule + dosHeader->e_lfanew);
+
+		out.base = (const uint8_t *)moduleInfo.lpBaseOfDll;
+		out.size = moduleInfo.SizeOfImage;
+		out.timestamp = ntHeaders->FileHeader.TimeDateStamp;
+		return true;
+	}
+
+	bool MatchesAt(const ModuleImage &image, int64_t offset, const Signature &sig)
+	{
+		return SigMatch::MatchesAt(image.base, image.size, offset, sig);
+	}
+
+	uint32_t HashSignature(const Signature &sig, int sigOffset)
+	{
+		// FNV-1a
+		uint32_t hash = 2166136261u;
+		for (size_t i = 0; i < sig.length; ++i)
+		{
+			hash = (hash ^ sig.bytes[i]) * 16777619u;
+			hash = (hash ^ sig.mask[i]) * 16777619u;
+		}
+		hash = (hash ^ (uint32_t)sigOffset) * 16777619u;
+		return hash;
+	}
+
+	size_t LoadCache(const char *cacheFile, CacheEntry *entries, size_t maxEntries)
+	{
+		FILE *file;
+		if (fopen_s(&file, cacheFile, "r") != 0)
+			return 0;
+
+		// <module> <image size> <timestamp> <signature hash> <offset>
+		size_t count = 0;
+		CacheEntry entry;
+		while (count < maxEntries &&
+			fscanf_s(file, "%63s %x %x %x %x", entry.moduleName, (unsigned int)MAX_MODULE_NAME, &entry.size, &entry.timestamp, &entry.hash, (unsigned int *)&entry.offset) == 5)
+		{
+			entries[count++] = entry;
+		}
+
+		fclose(file);
+		return count;
+	}
+
+	void SaveCache(const char *cacheFile, const CacheEntry *entries, size_t count)
+	{
+		FILE *file;
+		if (fopen_s(&file, cacheFile, "w") != 0)
+			return;
+
+		for (size_t i = 0; i < count; ++i)
+			fprintf(file, "%s %x %x %x %x\n", entries[i].moduleName, entries[i].size, entries[i].timestamp, entries[i].hash, (unsigned int)entries[i].offset);
+
+		fclose(file);
+	}
+}
+
+void SignatureSet::Resolve(const char *cacheFile)
+{
+	const auto startTime = std::chrono::steady_clock::now();
+
+	CacheEntry cache[MAX_ENTRIES];
+	const size_t numLoaded = LoadCache(cacheFile, cache, MAX_ENTRIES);
+
+	// Everything not matching its hardcoded offset ends up in the new cache
+	CacheEntry newCache[MAX_ENTRIES];
+	size_t numNewCache = 0;
+	bool cacheChanged = false;
+
+	static ModuleScan modules[MAX_MODULES];
+	size_t numModules = 0;
+	int numCached = 0;
+	int numScanned = 0;
+
+	const auto addCacheEntry = [&](const SignatureEntry &entry, const ModuleImage &image)
+	{
+		CacheEntry &cacheEntry = newCache[numNewCache++];
+		strncpy_s(cacheEntry.moduleName, entry.moduleName, _TRUNCATE);
+		cacheEntry.size = (uint32_t)image.size;
+		cacheEntry.timestamp = image.timestamp;
+		cacheEntry.hash = HashSignature(*entry.signature, entry.sigOffset);
+		cacheEntry.offset = *entry.offset;
+	};
+
+	const auto resolveEntry = [&](SignatureEntry &entry, const ModuleImage &image, int offset)
+	{
+		*entry.offset = offset;
+		*entry.address = (int)((uintptr_t)image.base + offset);
+		entry.resolved = true;
+	};
+
+	for (size_t i = 0; i < m_Count; ++i)
+	{
+		SignatureEntry &entry = m_Entries[i];
+		const Signature &sig = *entry.signature;
+		entry.resolved = false;
+
+		size_t m = 0;
+		while (m < numModules && strcmp(modules[m].moduleName, entry.moduleName) != 0)
+			++m;
+
+		if (m == numModules)
+		{
+			if (numModules == MAX_MODULES)
+				continue;
+
+			modules[m].moduleName = entry.moduleName;
+			modules[m].image = ModuleImage();
+			GetModuleImage(entry.moduleName, modules[m].image);
+			modules[m].scan.Reset(modules[m].image.base, modules[m].image.size);
+			++numModules;
+		}
+		ModuleScan &module = modules[m];
+
+		if (!module.image.base)
+			continue;
+
+		// Check if current offset is good
+		if (MatchesAt(module.image, (int64_t)*entry.offset - entry.sigOffset, sig))
+		{
+			resolveEntry(entry, module.image, *entry.offset);
+			continue;
+		}
+
+		const uint32_t hash = HashSignature(sig, entry.sigOffset);
+		const CacheEntry *cached = nullptr;
+		for (size_t c = 0; c < numLoaded && !cached; ++c)
+		{
+			if (cache[c].hash == hash && cache[c].size == module.image.size && cache[c].timestamp == module.image.timestamp &&
+				strcmp(cache[c].moduleName, entry.moduleName) == 0)
+			{
+				cached = &cache[c];
+			}
+		}
+
+		if (cached && MatchesAt(module.image, (int64_t)cached->offset - entry.sigOffset, sig))
+		{
+			resolveEntry(entry, module.image, cached->offset);
+			addCacheEntry(entry, module.image);
+			++numCached;
+			continue;
+		}
+
+		module.scan.Add(&sig, (uint8_t)i);
+	}
+
+	const bool useAVX2 = CpuSupportsAVX2();
+
+	for (size_t m = 0; m < numModules; ++m)
+	{
+		ModuleScan &module = modules[m];
+		SigMatch::PatternScan &scan = module.scan;
+		if (!scan.numPatterns)
+			continue;
+
+		SigMatch::Prepare(scan);
+		SigMatch::Scan(scan, useAVX2);
+
+		for (size_t p = 0; p < scan.numPatterns; ++p)
+		{
+			SignatureEntry &entry = m_Entries[scan.tags[p]];
+			const int64_t found = scan.found[p].load();
+			++numScanned;
+
+			if (found == INT64_MAX)
+				continue;
+
+			resolveEntry(entry, module.image, (int)found + entry.sigOffset);
+			addCacheEntry(entry, module.image);
+			cacheChanged = true;
+		}
+	}
+
+	if (cacheChanged || numNewCache != numLoaded)
+		SaveCache(cacheFile, newCache, numNewCache);
+
+	std::chrono::duration<float, std::milli> elapsed = std::chrono::steady_clock::now() - startTime;
+	std::cout << "Resolved " << m_Count << " offsets in " << elapsed.count() << " ms ("
+		<< numCached << " from cache, " << numScanned << " scanned" << (useAVX2 ? ", AVX2" : ", SSE2") << ")\n";
+}
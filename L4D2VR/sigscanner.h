@@ -1,68 +1,149 @@
 #pragma once
-#include <Windows.h>
-#include <psapi.h>
-#include <vector>
-#include <sstream>
+#include <cstdint>
+#include <cstddef>
+#include <stdexcept>
 
-class SigScanner
+constexpr size_t MAX_SIG_LEN = 128;
+
+// A signature compiled into raw bytes plus a match mask (0xFF = must match, 0x00 = wildcard).
+// 'anchor' is the index of the byte used by the SIMD pre-filter, picked to be as rare as possible.
+struct Signature
+{
+	const char *text = nullptr;
+	uint8_t bytes[MAX_SIG_LEN] = {};
+	uint8_t mask[MAX_SIG_LEN] = {};
+	uint8_t length = 0;
+	uint8_t anchor = 0;
+};
+
+struct SignatureEntry
+{
+	const char *moduleName;
+	const Signature *signature;
+	int sigOffset;
+	int *offset;			// In: hardcoded offset, out: resolved offset
+	int *address;			// Out: module base + resolved offset
+	bool resolved = false;
+};
+
+// Flat table of every signature that needs resolving. Resolve() scans every module a single
+// time for all of its signatures, split across worker threads. Resolved offsets are stored in
+// 'cacheFile', keyed by module size and timestamp, so subsequent launches on the same game build
+// skip scanning entirely.
+class SignatureSet
 {
 public:
-	// Returns 0 if current offset matches, -1 if no matches found.
-	// A value > 0 is the new offset.
-	static int VerifyOffset(std::string moduleName, int currentOffset, std::string signature, int sigOffset = 0)
+	static constexpr size_t MAX_ENTRIES = 128;
+
+	bool Add(const SignatureEntry &entry)
 	{
-		HMODULE hModule = GetModuleHandle(moduleName.c_str());
-		MODULEINFO moduleInfo;
-		GetModuleInformation(GetCurrentProcess(), hModule, &moduleInfo, sizeof(moduleInfo));
+		if (m_Count == MAX_ENTRIES)
+			return false;
 
-		uint8_t *bytes = (uint8_t *)moduleInfo.lpBaseOfDll;
+		m_Entries[m_Count++] = entry;
+		return true;
+	}
 
-		std::vector<int> pattern;
+	void Resolve(const char *cacheFile);
 
-		std::stringstream ss(signature);
-		std::string sigByte;
-		while (ss >> sigByte)
-		{
-			if (sigByte == "?" || sigByte == "??")
-				pattern.push_back(-1);
-			else
-				pattern.push_back(strtoul(sigByte.c_str(), NULL, 16));
-		}
+	size_t Count() const { return m_Count; }
+	const SignatureEntry &operator[](size_t i) const { return m_Entries[i]; }
 
-		int patternLen = pattern.size();
+private:
+	SignatureEntry m_Entries[MAX_ENTRIES];
+	size_t m_Count = 0;
+};
 
-		// Check if current offset is good
-		bool offsetMatchesSig = true;
-		for (int i = 0; i < patternLen; ++i)
+class SigScanner
+{
+public:
+	// Turns "55 8B EC ? ?" into a Signature. Meant to be evaluated at compile time through SIG(),
+	// malformed signatures then fail the build instead of failing at startup.
+	static constexpr Signature CompileSignature(const char *text)
+	{
+		Signature sig;
+		sig.text = text;
+
+		for (size_t i = 0; text[i]; )
 		{
-			if ( (bytes[currentOffset - sigOffset + i] != pattern[i]) && (pattern[i] != -1) )
+			if (text[i] == ' ')
 			{
-				offsetMatchesSig = false;
-				break;
+				++i;
+				continue;
 			}
-		}
 
-		if (offsetMatchesSig)
-			return 0;
+			if (sig.length == MAX_SIG_LEN)
+				throw std::length_error("Signature is longer than MAX_SIG_LEN");
 
-		// Scan the dll for new offset
-		for (int i = 0; i < moduleInfo.SizeOfImage; ++i)
-		{
-			bool found = true;
-			for (int j = 0; j < patternLen; ++j)
+			if (text[i] == '?')
 			{
-				if ((bytes[i + j] != pattern[j]) && (pattern[j] != -1))
-				{
-					found = false;
-					break;
-				}
+				i += (text[i + 1] == '?') ? 2 : 1;
+				sig.bytes[sig.length] = 0;
+				sig.mask[sig.length] = 0;
 			}
-			if (found)
+			else
 			{
-				return i + sigOffset;
+				const int hi = HexDigit(text[i]);
+				const int lo = HexDigit(text[i + 1]);
+				if (hi < 0 || lo < 0)
+					throw std::invalid_argument("Signature contains an invalid byte");
+
+				i += 2;
+				sig.bytes[sig.length] = (uint8_t)((hi << 4) | lo);
+				sig.mask[sig.length] = 0xFF;
 			}
+
+			if (text[i] != ' ' && text[i] != '\0')
+				throw std::invalid_argument("Signature bytes must be separated by spaces");
+
+			++sig.length;
 		}
+
+		// Prefer a rare byte as anchor, otherwise fall back to the first non-wildcard one
+		int firstFixed = -1;
+		int anchor = -1;
+		for (int i = 0; i < sig.length && anchor == -1; ++i)
+		{
+			if (!sig.mask[i])
+				continue;
+			if (firstFixed == -1)
+				firstFixed = i;
+			if (!IsCommonByte(sig.bytes[i]))
+				anchor = i;
+		}
+
+		if (firstFixed == -1)
+			throw std::invalid_argument("Signature has no fixed bytes");
+
+		sig.anchor = (uint8_t)(anchor != -1 ? anchor : firstFixed);
+		return sig;
+	}
+
+private:
+	static constexpr int HexDigit(char c)
+	{
+		if (c >= '0' && c <= '9')
+			return c - '0';
+		if (c >= 'A' && c <= 'F')
+			return c - 'A' + 10;
+		if (c >= 'a' && c <= 'f')
+			return c - 'a' + 10;
 		return -1;
+	}
 
+	// Bytes that show up everywhere in x86 code (prologues, padding, mov, call), bad anchor candidates
+	static constexpr bool IsCommonByte(uint8_t byte)
+	{
+		switch (byte)
+		{
+		case 0x00: case 0xFF: case 0xCC: case 0x8B: case 0x55: case 0x89:
+		case 0xE8: case 0x83: case 0xEC: case 0x56: case 0x57: case 0x53:
+			return true;
+		default:
+			return false;
+		}
 	}
-};
\ No newline at end of file
+};
+
+// Compiles a signature literal at compile time into static storage
+#define SIG(text) ([]() -> const Signature * { static constexpr Signature sig = SigScanner::CompileSignature(text); return &sig; }())
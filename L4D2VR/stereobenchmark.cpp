@@ -0,0 +1,63 @@
+#include "stereobenchmark.h"
+#include <algorithm>
+
+void StereoBenchmark::Start(int blockFrames, int blocks, int warmUpFrames)
+{
+	m_BlockFrames = std::max(blockFrames, 1);
+	m_Blocks = std::max(blocks, 2);
+	m_WarmUpFrames = std::clamp(warmUpFrames, 0, m_BlockFrames - 1);
+	m_Block = 0;
+	m_FrameInBlock = 0;
+
+	for (std::vector<uint64_t> &samples : m_Samples)
+	{
+		samples.clear();
+		samples.reserve((size_t)(m_BlockFrames - m_WarmUpFrames) * ((m_Blocks + 1) / 2));
+	}
+
+	m_Running = true;
+}
+
+bool StereoBenchmark::AddFrame(uint64_t nanoseconds)
+{
+	if (!m_Running)
+		return false;
+
+	if (m_FrameInBlock >= m_WarmUpFrames)
+		m_Samples[SharedPasses()].push_back(nanoseconds);
+
+	if (++m_FrameInBlock < m_BlockFrames)
+		return false;
+
+	m_FrameInBlock = 0;
+	if (++m_Block < m_Blocks)
+		return false;
+
+	m_Running = false;
+	return true;
+}
+
+StereoBenchmark::Result StereoBenchmark::GetResult(bool sharedPasses) const
+{
+	std::vector<uint64_t> samples = m_Samples[sharedPasses];
+	Result result;
+	if (samples.empty())
+		return result;
+
+	std::sort(samples.begin(), samples.end());
+
+	double sum = 0.0;
+	for (uint64_t sample : samples)
+		sum += sample;
+
+	const auto percentile = [&](double p)
+	{
+		return samples[std::min((size_t)(p * samples.size()), samples.size() - 1)] / 1e6;
+	};
+
+	result.m_Frames = samples.size();
+	result.m_MeanMs = sum / samples.size() / 1e6;
+	result.m_P50Ms = percentile(0.50);
+	result.m_P95Ms = percentile(0.95);
+	return result;
+}
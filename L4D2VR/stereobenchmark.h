@@ -0,0 +1,44 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Compares how long the eyes take to render with and without the right eye sharing the left eye's view independent
+// passes. Frames are measured in alternating blocks, so a scene that gets busier or calmer during the run weighs on
+// both variants alike. The first frames of every block are dropped, they can still pay for the previous variant.
+class StereoBenchmark
+{
+public:
+	static constexpr int DEFAULT_BLOCK_FRAMES = 90;
+	static constexpr int DEFAULT_BLOCKS = 20;
+	static constexpr int DEFAULT_WARM_UP_FRAMES = 10;
+
+	struct Result
+	{
+		size_t m_Frames = 0;
+		double m_MeanMs = 0.0;
+		double m_P50Ms = 0.0;
+		double m_P95Ms = 0.0;
+	};
+
+	// Blocks alternate between the two variants, starting with the one that doesn't share passes
+	void Start(int blockFrames = DEFAULT_BLOCK_FRAMES, int blocks = DEFAULT_BLOCKS, int warmUpFrames = DEFAULT_WARM_UP_FRAMES);
+	bool IsRunning() const { return m_Running; }
+
+	// Which variant the current frame has to be rendered with
+	bool SharedPasses() const { return m_Block % 2 == 1; }
+
+	// Time the eyes of the current frame took. Returns true if that was the last frame of the run.
+	bool AddFrame(uint64_t nanoseconds);
+
+	Result GetResult(bool sharedPasses) const;
+
+private:
+	bool m_Running = false;
+	int m_BlockFrames = 0;
+	int m_Blocks = 0;
+	int m_WarmUpFrames = 0;
+	int m_Block = 0;
+	int m_FrameInBlock = 0;
+	std::vector<uint64_t> m_Samples[2];	// Indexed by SharedPasses()
+};
@@ -14,6 +14,9 @@
 #include <type_traits>
 #include <algorithm>
 #include <d3d9_vr.h>
+#include "prediction.h"
+#include "frametiming.h"
+#include "rendercontext.h"
 
 VR::VR(Game *game) 
 {
@@ -43,7 +46,13 @@ VR::VR(Game *game)
     m_System = vr::OpenVRInternal_ModuleContext().VRSystem();
 
     m_System->GetRecommendedRenderTargetSize(&m_RenderWidth, &m_RenderHeight);
-    m_AntiAliasing = 0;
+    m_EyeTextureWidth = m_ViewportWidth = m_RenderWidth;
+    m_EyeTextureHeight = m_ViewportHeight = m_RenderHeight;
+
+    float displayFrequency = m_System->GetFloatTrackedDeviceProperty(vr::k_unTrackedDeviceIndex_Hmd, vr::Prop_DisplayFrequency_Float);
+    if (displayFrequency > 0)
+        m_DisplayFrequency = displayFrequency;
+    m_InputSource.Init(m_System, vr::VRCompositor(), m_Input);
 
     float l_left = 0.0f, l_right = 0.0f, l_top = 0.0f, l_bottom = 0.0f;
     m_System->GetProjectionRaw(vr::EVREye::Eye_Left, &l_left, &l_right, &l_top, &l_bottom);
@@ -72,6 +81,9 @@ VR::VR(Game *game)
     InstallApplicationManifest("manifest.vrmanifest");
     SetActionManifest("action_manifest.json");
 
+    ReloadConfig();
+    ApplySettings();
+
     std::thread configParser(&VR::WaitForConfigUpdate, this);
     configParser.detach();
 
@@ -81,16 +93,15 @@ VR::VR(Game *game)
     g_D3DVR9->GetBackBufferData(&m_VKBackBuffer);
     m_Overlay = vr::VROverlay();
     m_Overlay->CreateOverlay("MenuOverlayKey", "MenuOverlay", &m_MainMenuHandle);
-    //m_Overlay->CreateOverlay("HUDOverlayKey", "HUDOverlay", &m_HUDHandle);
+    m_HudCompositor.Create(m_Overlay);
     m_Overlay->SetOverlayInputMethod(m_MainMenuHandle, vr::VROverlayInputMethod_Mouse);
    // m_Overlay->SetOverlayInputMethod(m_HUDHandle, vr::VROverlayInputMethod_Mouse);
     m_Overlay->SetOverlayFlag(m_MainMenuHandle, vr::VROverlayFlags_SendVRDiscreteScrollEvents, true);
     //m_Overlay->SetOverlayFlag(m_HUDHandle, vr::VROverlayFlags_SendVRDiscreteScrollEvents, true);
 
-    int windowWidth, windowHeight;
-    m_Game->m_MaterialSystem->GetRenderContext()->GetWindowSize(windowWidth, windowHeight);
+    UpdateFrameState();
 
-    //const vr::HmdVector2_t mouseScaleHUD = {windowWidth, windowHeight};
+    //const vr::HmdVector2_t mouseScaleHUD = {m_FrameState.m_WindowWidth, m_FrameState.m_WindowHeight};
     //m_Overlay->SetOverlayMouseScale(m_HUDHandle, &mouseScaleHUD);
 
     const vr::HmdVector2_t mouseScaleMenu = {m_RenderWidth, m_RenderHeight};
@@ -103,6 +114,12 @@ VR::VR(Game *game)
 
     UpdatePosesAndActions();
 
+    std::thread poseTracker(&VR::TrackPoses, this);
+    poseTracker.detach();
+
+    std::thread submitter(&VR::SubmitThread, this);
+    submitter.detach();
+
     m_IsInitialized = true;
     m_IsVREnabled = true;
 }
@@ -183,32 +200,108 @@ void VR::SetScreenSizeOverride(bool bState) {
     }
 }
 
+void VR::WarmUpPipelines()
+{
+    TIME_SCOPE(Timing_PipelineWarmUp);
+
+    // Queues every cached pipeline whose shaders exist by now, i.e. the ones the loaded map can use
+    UINT queued = 0;
+    if (FAILED(g_D3DVR9->BeginPipelineWarmUp(m_PipelineWarmUpThreads, &queued)))
+    {
+        std::cout << "Pipeline warm-up isn't supported by this dxvk build\n";
+        return;
+    }
+
+    typedef std::chrono::duration<float, std::milli> milliseconds;
+    const auto start = std::chrono::steady_clock::now();
+    auto lastReport = start;
+    UINT pending = queued;
+
+    std::cout << "Pipeline warm-up: compiling " << queued << " cached pipelines on " << m_PipelineWarmUpThreads << " extra threads\n";
+
+    while (SUCCEEDED(g_D3DVR9->GetPendingPipelineCount(&pending)) && pending > 0)
+    {
+        const auto now = std::chrono::steady_clock::now();
+        if (milliseconds(now - start).count() >= m_PipelineWarmUpBudgetMs)
+            break;
+
+        if (milliseconds(now - lastReport).count() >= 500.0f)
+        {
+            std::cout << "Pipeline warm-up: " << pending << " pipelines left\n";
+            lastReport = now;
+        }
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }
+
+    g_D3DVR9->EndPipelineWarmUp();
+
+    const float elapsedMs = milliseconds(std::chrono::steady_clock::now() - start).count();
+    if (pending == 0)
+        std::cout << "Pipeline warm-up finished in " << elapsedMs << " ms\n";
+    else
+        std::cout << "Pipeline warm-up ran out of time after " << elapsedMs << " ms, " << pending << " pipelines left to compile in the background\n";
+}
+
 void VR::Update()
 {
     if (!m_IsInitialized || !m_Game->m_Initialized)
         return;
 
-    
+    ++m_FrameNumber;
+    m_Game->UpdateFrameCache();
+    const bool wasInGame = m_FrameState.m_IsInGame;
+    UpdateFrameState();
 
-    if (m_IsVREnabled && g_D3DVR9)
+    ApplySettings();
+
+    FrameTiming::SetEnabled(m_FrameTiming);
+    FrameTiming::Tick();
+
+    // Command numbers start over with the next connection, payloads sent on this one must not become its baselines
+    if (m_FrameState.m_IsInGame != wasInGame)
+        m_SentUsercmds.Clear();
+
+    // The map finished loading, its materials created their shaders but nothing was drawn in the headset yet
+    if (m_PipelineWarmUp && m_IsVREnabled && g_D3DVR9 && m_FrameState.m_IsInGame && !wasInGame)
+        WarmUpPipelines();
+
+    // Only react to the config changing, a failed open or a finished replay shouldn't be retried every frame
+    if (m_InputRecordingMode != m_AppliedInputRecordingMode)
     {
-        bool inGame = m_Game->m_EngineClient->IsInGame();
+        m_AppliedInputRecordingMode = m_InputRecordingMode;
+        m_InputSource.Recording().SetMode((InputRecording::Mode)std::clamp(m_InputRecordingMode, 0, 2), "VR\\input.rec");
+    }
+
+    if (m_RunStereoBenchmark != m_AppliedRunStereoBenchmark)
+    {
+        m_AppliedRunStereoBenchmark = m_RunStereoBenchmark;
+        if (m_RunStereoBenchmark)
+        {
+            std::cout << "Stereo benchmark: rendering " << StereoBenchmark::DEFAULT_BLOCKS * StereoBenchmark::DEFAULT_BLOCK_FRAMES
+                << " frames, alternating between separate and shared eye passes\n";
+            m_StereoBenchmark.Start();
+        }
+    }
+
+    TIME_SCOPE(Timing_Update);
 
-        //SetScreenSizeOverride(inGame);
+    if (m_IsVREnabled && g_D3DVR9)
+    {
+        //SetScreenSizeOverride(m_FrameState.m_IsInGame);
 
         // Prevents crashing at menu
-        if (!inGame)
+        if (!m_FrameState.m_IsInGame)
         {
-            IMatRenderContext *rndrContext = m_Game->m_MaterialSystem->GetRenderContext();
-            rndrContext->SetRenderTarget(NULL);
-            rndrContext->Release();
+            RenderContextScope(m_Game->m_MaterialSystem)->SetRenderTarget(NULL);
 
             m_Game->m_CachedArmsModel = false;
-            m_CreatedVRTextures = false; // Have to recreate textures otherwise some workshop maps won't render
+            m_CreatedVRTextures = false; // Revalidate the textures, some workshop maps drop them. Only what changed is reallocated.
         } 
     }
 
     SubmitVRTextures();
+    UpdateDynamicResolution();
     UpdatePosesAndActions();
     UpdateTracking();
 
@@ -219,48 +312,222 @@ void VR::Update()
         m_InitialPosReset = true;
     }
 
-    if (m_Game->m_VguiSurface->IsCursorVisible()) {
+    if (m_FrameState.m_IsCursorVisible) {
         ProcessMenuInput();
     } else {
         ProcessInput();
     }
 }
 
+void VR::UpdateFrameState()
+{
+    VRFrameState state;
+    RenderContextScope(m_Game->m_MaterialSystem)->GetWindowSize(state.m_WindowWidth, state.m_WindowHeight);
+    state.m_RenderWidth = m_RenderWidth;
+    state.m_RenderHeight = m_RenderHeight;
+    state.m_IsInGame = m_Game->m_EngineClient->IsInGame();
+    state.m_IsCursorVisible = m_Game->m_VguiSurface->IsCursorVisible();
+
+    if (state.m_WindowWidth != m_FrameState.m_WindowWidth || state.m_WindowHeight != m_FrameState.m_WindowHeight)
+        std::cout << "Window size changed to " << state.m_WindowWidth << "x" << state.m_WindowHeight << "\n";
+    if (state.m_IsInGame != m_FrameState.m_IsInGame)
+        std::cout << (state.m_IsInGame ? "Entered game\n" : "Left game\n");
+
+    m_FrameState = state;
+}
+
 void VR::CreateVRTextures()
 {
-    int windowWidth, windowHeight;
+    WaitForAsyncSubmit();
 
-    IMatRenderContext* rndrContext = m_Game->m_MaterialSystem->GetRenderContext();
-    rndrContext->GetWindowSize(windowWidth, windowHeight);
-    rndrContext->Release();
+    // Allocate for the largest scale dynamic resolution may pick, it only ever renders into part of the texture
+    float maxScale = m_DynamicResolution ? std::max(m_DynamicResolutionMaxScale, 1.0f) : 1.0f;
+    m_EyeTextureWidth = (uint32_t)(m_RenderWidth * maxScale);
+    m_EyeTextureHeight = (uint32_t)(m_RenderHeight * maxScale);
 
-    std::cout << "RenderTexture - Width: " << m_RenderWidth << ", Height: " << m_RenderHeight << "\n";
+    m_DepthTextureActive = m_SubmitDepth;
+    m_HudOverlayActive = m_HudOverlay;
+    m_EyeTextureSetCount = std::clamp(m_EyeTextureBuffers, 1, (int)MAX_EYE_TEXTURE_SETS);
 
-    m_Game->m_MaterialSystem->isGameRunning = false;
-    m_Game->m_MaterialSystem->BeginRenderTargetAllocation();
-    m_Game->m_MaterialSystem->isGameRunning = true;
+    const int format = m_Game->m_MaterialSystem->GetBackBufferFormat();
+    const auto eyeKey = [&](const char *prefix, uint32_t index)
+    {
+        return RenderTargetKey{ prefix + std::to_string(index), (int)m_EyeTextureWidth, (int)m_EyeTextureHeight, format, MATERIAL_RT_DEPTH_SEPARATE, m_AntiAliasing, m_DepthTextureActive };
+    };
 
-    m_CreatingTextureID = Texture_LeftEye;
-    m_LeftEyeTexture = m_Game->m_MaterialSystem->CreateNamedRenderTargetTextureEx("leftEye0", m_RenderWidth, m_RenderHeight, RT_SIZE_NO_CHANGE, m_Game->m_MaterialSystem->GetBackBufferFormat(), MATERIAL_RT_DEPTH_SEPARATE, TEXTUREFLAGS_NOMIP);
-    
-    m_CreatingTextureID = Texture_RightEye;
-    m_RightEyeTexture = m_Game->m_MaterialSystem->CreateNamedRenderTargetTextureEx("rightEye0", m_RenderWidth, m_RenderHeight, RT_SIZE_NO_CHANGE, m_Game->m_MaterialSystem->GetBackBufferFormat(), MATERIAL_RT_DEPTH_SEPARATE, TEXTUREFLAGS_NOMIP);
+    // Every target in the order it's created
+    std::vector<std::pair<RenderTargetKey, TextureID>> targets;
+    for (uint32_t i = 0; i < m_EyeTextureSetCount; ++i)
+    {
+        targets.push_back({ eyeKey("leftEye", i), Texture_LeftEye });
+        targets.push_back({ eyeKey("rightEye", i), Texture_RightEye });
+    }
+    // Only needed for the HUD overlay, the HUD pass paints nothing without it
+    if (m_HudOverlayActive)
+        targets.push_back({ { "vrHUD", (int)m_RenderWidth, (int)m_RenderHeight, format, MATERIAL_RT_DEPTH_SHARED }, Texture_HUD });
+    targets.push_back({ { "blankTexture", 512, 512, format, MATERIAL_RT_DEPTH_SHARED }, Texture_Blank });
 
-    m_CreatingTextureID = Texture_HUD;
-    m_HUDTexture = m_Game->m_MaterialSystem->CreateNamedRenderTargetTextureEx("vrHUD", m_RenderWidth, m_RenderHeight, RT_SIZE_NO_CHANGE, m_Game->m_MaterialSystem->GetBackBufferFormat(), MATERIAL_RT_DEPTH_SHARED, TEXTUREFLAGS_NOMIP);
-    
-    m_CreatingTextureID = Texture_Blank;
-    m_BlankTexture = m_Game->m_MaterialSystem->CreateNamedRenderTargetTextureEx("blankTexture", 512, 512, RT_SIZE_NO_CHANGE, m_Game->m_MaterialSystem->GetBackBufferFormat(), MATERIAL_RT_DEPTH_SHARED, TEXTUREFLAGS_NOMIP);
-    
-    m_CreatingTextureID = Texture_None;
+    // Only go through an allocation cycle when a target actually has to be (re)created, or one is no longer
+    // used and can be freed. The material system only lets go of render targets in an allocation cycle.
+    const bool allocate = m_RenderTargetPool.Size() > targets.size()
+        || std::any_of(targets.begin(), targets.end(), [this](const auto &target) { return !m_RenderTargetPool.Find(target.first); });
+
+    if (allocate)
+    {
+        std::cout << "RenderTexture - Width: " << m_EyeTextureWidth << ", Height: " << m_EyeTextureHeight << "\n";
+
+        m_Game->m_MaterialSystem->isGameRunning = false;
+        m_Game->m_MaterialSystem->BeginRenderTargetAllocation();
+        m_Game->m_MaterialSystem->isGameRunning = true;
+    }
+
+    auto target = targets.begin();
+    for (uint32_t i = 0; i < m_EyeTextureSetCount; ++i)
+    {
+        EyeTextureSet &set = m_EyeTextureSets[i];
+
+        const PooledRenderTarget &left = AcquireRenderTarget(target->first, target->second);
+        ++target;
+        const PooledRenderTarget &right = AcquireRenderTarget(target->first, target->second);
+        ++target;
+
+        set.m_LeftEyeTexture = left.m_Texture;
+        set.m_D9LeftEyeSurface = left.m_Surface;
+        set.m_VKLeftEye = left.m_SharedTexture;
+        set.m_RightEyeTexture = right.m_Texture;
+        set.m_D9RightEyeSurface = right.m_Surface;
+        set.m_VKRightEye = right.m_SharedTexture;
+
+        // Same for the depth buffers the material system creates along with them
+        set.m_D9LeftEyeDepthSurface = left.m_DepthSurface;
+        set.m_VKLeftEyeDepth = left.m_SharedDepth;
+        set.m_D9RightEyeDepthSurface = right.m_DepthSurface;
+        set.m_VKRightEyeDepth = right.m_SharedDepth;
+
+        if (allocate && m_DepthTextureActive && (!set.m_D9LeftEyeDepthSurface || !set.m_D9RightEyeDepthSurface))
+            std::cout << "Eye texture set " << i << " has no shareable depth buffer, submitting color only\n";
+    }
+
+    if (m_HudOverlayActive)
+    {
+        const PooledRenderTarget &hud = AcquireRenderTarget(target->first, target->second);
+        ++target;
+        m_HUDTexture = hud.m_Texture;
+        m_D9HUDSurface = hud.m_Surface;
+        m_VKHUD = hud.m_SharedTexture;
+    }
+    else
+    {
+        m_HUDTexture = nullptr;
+        m_D9HUDSurface = nullptr;
+        m_VKHUD = {};
+    }
+
+    const PooledRenderTarget &blank = AcquireRenderTarget(target->first, target->second);
+    m_BlankTexture = blank.m_Texture;
+    m_D9BlankSurface = blank.m_Surface;
+    m_VKBlankTexture = blank.m_SharedTexture;
+
+    if (allocate)
+    {
+        m_Game->m_MaterialSystem->EndRenderTargetAllocation();
+
+        // Drop what's left over from a previous configuration, e.g. a third eye texture set
+        std::vector<RenderTargetKey> keys;
+        for (const auto &requested : targets)
+            keys.push_back(requested.first);
+        m_RenderTargetPool.Retain(keys);
+    }
 
-    m_Game->m_MaterialSystem->EndRenderTargetAllocation();
+    m_EyeTextureSetIndex = 0;
+    SelectEyeTextureSet(0);
 
     m_CreatedVRTextures = true;
 }
 
+// Hands out the pooled target for 'key', or creates it if there's none. Creating only works between
+// Begin/EndRenderTargetAllocation, see CreateVRTextures.
+const PooledRenderTarget &VR::AcquireRenderTarget(const RenderTargetKey &key, TextureID textureID)
+{
+    if (const PooledRenderTarget *pooled = m_RenderTargetPool.Find(key))
+        return *pooled;
+
+    // dxvk fills in the shared texture and surfaces of whatever it creates while m_CreatingTextureID is set
+    PooledRenderTarget created;
+    created.m_Key = key;
+    m_D9LeftEyeSurface = m_D9RightEyeSurface = m_D9HUDSurface = m_D9BlankSurface = nullptr;
+    m_D9LeftEyeDepthSurface = m_D9RightEyeDepthSurface = nullptr;
+
+    m_CreatingTextureID = textureID;
+    created.m_Texture = m_Game->m_MaterialSystem->CreateNamedRenderTargetTextureEx(key.m_Name.c_str(), key.m_Width, key.m_Height, RT_SIZE_NO_CHANGE, (ImageFormat)key.m_Format, (MaterialRenderTargetDepth_t)key.m_Depth, TEXTUREFLAGS_NOMIP);
+    m_CreatingTextureID = Texture_None;
+
+    switch (textureID)
+    {
+    case Texture_LeftEye:
+        created.m_Surface = m_D9LeftEyeSurface;
+        created.m_SharedTexture = m_VKLeftEye;
+        created.m_DepthSurface = m_D9LeftEyeDepthSurface;
+        created.m_SharedDepth = m_VKLeftEyeDepth;
+        break;
+    case Texture_RightEye:
+        created.m_Surface = m_D9RightEyeSurface;
+        created.m_SharedTexture = m_VKRightEye;
+        created.m_DepthSurface = m_D9RightEyeDepthSurface;
+        created.m_SharedDepth = m_VKRightEyeDepth;
+        break;
+    case Texture_HUD:
+        created.m_Surface = m_D9HUDSurface;
+        created.m_SharedTexture = m_VKHUD;
+        break;
+    case Texture_Blank:
+        created.m_Surface = m_D9BlankSurface;
+        created.m_SharedTexture = m_VKBlankTexture;
+        break;
+    default:
+        break;
+    }
+
+    return m_RenderTargetPool.Store(created);
+}
+
+void VR::SelectEyeTextureSet(uint32_t index)
+{
+    const EyeTextureSet &set = m_EyeTextureSets[index];
+
+    m_LeftEyeTexture = set.m_LeftEyeTexture;
+    m_RightEyeTexture = set.m_RightEyeTexture;
+    m_D9LeftEyeSurface = set.m_D9LeftEyeSurface;
+    m_D9RightEyeSurface = set.m_D9RightEyeSurface;
+    m_VKLeftEye = set.m_VKLeftEye;
+    m_VKRightEye = set.m_VKRightEye;
+    m_D9LeftEyeDepthSurface = set.m_D9LeftEyeDepthSurface;
+    m_D9RightEyeDepthSurface = set.m_D9RightEyeDepthSurface;
+    m_VKLeftEyeDepth = set.m_VKLeftEyeDepth;
+    m_VKRightEyeDepth = set.m_VKRightEyeDepth;
+}
+
+// Switches to the next eye texture set before a frame is rendered. The set that was just submitted
+// is left alone, so with 2+ sets rendering doesn't have to wait for the compositor to pick it up.
+void VR::AcquireNextEyeTextureSet()
+{
+    m_EyeTextureSetIndex = (m_EyeTextureSetIndex + 1) % m_EyeTextureSetCount;
+    SelectEyeTextureSet(m_EyeTextureSetIndex);
+
+    if (m_SubmitSurfaceCount > 0 && m_SubmitSurfaces[0] == m_D9LeftEyeSurface)
+        WaitForAsyncSubmit();
+}
+
 void VR::SubmitVRTextures()
 {
+    TIME_SCOPE(Timing_SubmitVRTextures);
+
+    // The blank texture and overlays below don't go through the submit thread, it must be done with the queue
+    WaitForAsyncSubmit();
+
+    // Whatever HUD texture was queued last frame reached the overlay by now
+    m_HudCompositor.ShowIfReady();
+
     if (!m_RenderedNewFrame)
     {
         if (!m_BlankTexture)
@@ -270,17 +537,12 @@ void VR::SubmitVRTextures()
             RepositionOverlays();
 
         vr::VRTextureBounds_t bounds{ 0, 0, 1, 1 };
-        if (m_Game->m_EngineClient->IsInGame())
+        if (m_FrameState.m_IsInGame)
         {
             // menu only renders to the window portion of the texture. Until we figure out a proper fix,
             // as a workaround only show that portion of the texture
-            int windowWidth, windowHeight;
-            IMatRenderContext* rndrContext = m_Game->m_MaterialSystem->GetRenderContext();
-            rndrContext->GetWindowSize(windowWidth, windowHeight);
-            rndrContext->Release();
-
-            bounds.uMax = (float)windowWidth / m_RenderWidth;
-            bounds.vMax = (float)windowHeight / m_RenderHeight;
+            bounds.uMax = (float)m_FrameState.m_WindowWidth / m_FrameState.m_RenderWidth;
+            bounds.vMax = (float)m_FrameState.m_WindowHeight / m_FrameState.m_RenderHeight;
             vr::VROverlay()->SetOverlayTexelAspect(m_MainMenuHandle, bounds.vMax / bounds.uMax);
         }
         else
@@ -289,7 +551,7 @@ void VR::SubmitVRTextures()
         vr::VROverlay()->SetOverlayTextureBounds(m_MainMenuHandle, &bounds);
         vr::VROverlay()->SetOverlayTexture(m_MainMenuHandle, &m_VKBackBuffer.m_VRTexture);
         vr::VROverlay()->ShowOverlay(m_MainMenuHandle);
-        //vr::VROverlay()->HideOverlay(m_HUDHandle);
+        m_HudCompositor.SetWanted(false);
 
         //if (!m_Game->m_EngineClient->IsInGame())
         {
@@ -301,20 +563,318 @@ void VR::SubmitVRTextures()
     }
     vr::VROverlay()->HideOverlay(m_MainMenuHandle);
 
-    //vr::VROverlay()->SetOverlayTexture(m_HUDHandle, &m_VKHUD.m_VRTexture);
+    // The HUD overlay keeps showing its last texture, it's only set again when the HUD pass repainted it
+    const bool submitHud = m_HudCompositor.TakeRepainted() && m_D9HUDSurface;
 
-    if (m_Game->m_VguiSurface->IsCursorVisible())
+    vr::VRTextureBounds_t leftBounds = GetSubmitBounds(vr::Eye_Left);
+    vr::VRTextureBounds_t rightBounds = GetSubmitBounds(vr::Eye_Right);
+
+    if (m_AsyncSubmitFrame)
+    {
+        QueueAsyncSubmit(leftBounds, rightBounds, submitHud);
+    }
+    else
     {
-        // We're in the pause menu
-        //vr::VROverlay()->ShowOverlay(m_HUDHandle);
+        vr::VRTextureWithPoseAndDepth_t leftTexture, rightTexture;
+        vr::EVRSubmitFlags leftFlags = GetSubmitTexture(vr::Eye_Left, leftTexture);
+        vr::EVRSubmitFlags rightFlags = GetSubmitTexture(vr::Eye_Right, rightTexture);
+
+        vr::VRCompositor()->Submit(vr::Eye_Left, &leftTexture, &leftBounds, leftFlags);
+        vr::VRCompositor()->Submit(vr::Eye_Right, &rightTexture, &rightBounds, rightFlags);
+
+        if (submitHud)
+            m_HudCompositor.SetTexture(m_VKHUD.m_VRTexture);
     }
 
-    vr::VRCompositor()->Submit(vr::Eye_Left, &m_VKLeftEye.m_VRTexture, &(m_TextureBounds)[0], vr::Submit_Default);
-    vr::VRCompositor()->Submit(vr::Eye_Right, &m_VKRightEye.m_VRTexture, &(m_TextureBounds)[1], vr::Submit_Default);
+    if (submitHud)
+        m_HudCompositor.QueueTexture();
 
+    m_AsyncSubmitFrame = false;
     m_RenderedNewFrame = false;
 }
 
+// Called by dxvk's Present right before Update(). Returns true if this frame's eye textures will be
+// submitted from the submit thread, dxvk then skips waiting for the device to go idle.
+bool VR::BeginAsyncSubmitFrame()
+{
+    m_AsyncSubmitFrame = m_AsyncSubmit && m_IsInitialized && m_CreatedVRTextures && m_RenderedNewFrame;
+    return m_AsyncSubmitFrame;
+}
+
+void VR::QueueAsyncSubmit(const vr::VRTextureBounds_t &leftBounds, const vr::VRTextureBounds_t &rightBounds, bool submitHud)
+{
+    // The set's holders stay put while m_VKLeftEye/m_VKRightEye move on to the next set
+    vr::VRTextureWithPoseAndDepth_t textures[2];
+    vr::EVRSubmitFlags flags[2];
+    flags[vr::Eye_Left] = GetSubmitTexture(vr::Eye_Left, textures[vr::Eye_Left]);
+    flags[vr::Eye_Right] = GetSubmitTexture(vr::Eye_Right, textures[vr::Eye_Right]);
+
+    const EyeTextureSet &set = m_EyeTextureSets[m_EyeTextureSetIndex];
+    uint32_t surfaceCount = 0;
+    m_SubmitSurfaces[surfaceCount++] = set.m_D9LeftEyeSurface;
+    m_SubmitSurfaces[surfaceCount++] = set.m_D9RightEyeSurface;
+
+    if (flags[vr::Eye_Left] & vr::Submit_TextureWithDepth)
+    {
+        m_SubmitSurfaces[surfaceCount++] = set.m_D9LeftEyeDepthSurface;
+        m_SubmitSurfaces[surfaceCount++] = set.m_D9RightEyeDepthSurface;
+    }
+
+    // SetOverlayTexture copies on the same queue as Submit, so the HUD goes along with the eyes
+    if (submitHud)
+        m_SubmitSurfaces[surfaceCount++] = m_D9HUDSurface;
+
+    uint64_t sequenceNumber;
+    if (FAILED(g_D3DVR9->PrepareSubmit(m_SubmitSurfaces, surfaceCount, &sequenceNumber)))
+    {
+        g_D3DVR9->WaitDeviceIdle();
+        vr::VRCompositor()->Submit(vr::Eye_Left, &textures[vr::Eye_Left], &leftBounds, flags[vr::Eye_Left]);
+        vr::VRCompositor()->Submit(vr::Eye_Right, &textures[vr::Eye_Right], &rightBounds, flags[vr::Eye_Right]);
+        if (submitHud)
+            m_HudCompositor.SetTexture(m_VKHUD.m_VRTexture);
+        return;
+    }
+
+    m_SubmitSurfaceCount = surfaceCount;
+    m_SubmitHud = submitHud;
+
+    {
+        std::lock_guard<std::mutex> lock(m_SubmitLock);
+        m_SubmitSequenceNumber = sequenceNumber;
+        std::copy(std::begin(textures), std::end(textures), m_SubmitTextures);
+        std::copy(std::begin(flags), std::end(flags), m_SubmitFlags);
+        m_SubmitBounds[vr::Eye_Left] = leftBounds;
+        m_SubmitBounds[vr::Eye_Right] = rightBounds;
+        m_SubmitPending = true;
+    }
+    m_SubmitCondition.notify_all();
+}
+
+// Blocks until the compositor has the last queued eye textures and makes them renderable again.
+// Must be called before rendering into the eye textures or recreating them.
+void VR::WaitForAsyncSubmit()
+{
+    if (m_SubmitSurfaceCount == 0)
+        return;
+
+    TIME_SCOPE(Timing_WaitForSubmit);
+
+    {
+        std::unique_lock<std::mutex> lock(m_SubmitLock);
+        m_SubmitCondition.wait(lock, [this] { return !m_SubmitPending; });
+    }
+
+    g_D3DVR9->FinishSubmit(m_SubmitSurfaces, m_SubmitSurfaceCount);
+    m_SubmitSurfaceCount = 0;
+    m_SubmitHud = false;
+}
+
+void VR::SubmitThread()
+{
+    while (1)
+    {
+        uint64_t sequenceNumber;
+        vr::VRTextureWithPoseAndDepth_t textures[2];
+        vr::EVRSubmitFlags flags[2];
+        vr::VRTextureBounds_t bounds[2];
+        bool submitHud;
+
+        {
+            std::unique_lock<std::mutex> lock(m_SubmitLock);
+            m_SubmitCondition.wait(lock, [this] { return m_SubmitPending; });
+
+            sequenceNumber = m_SubmitSequenceNumber;
+            std::copy(std::begin(m_SubmitTextures), std::end(m_SubmitTextures), textures);
+            std::copy(std::begin(m_SubmitFlags), std::end(m_SubmitFlags), flags);
+            std::copy(std::begin(m_SubmitBounds), std::end(m_SubmitBounds), bounds);
+            submitHud = m_SubmitHud;
+        }
+
+        {
+            TIME_SCOPE(Timing_AsyncSubmit);
+
+            // Waits for the frame to reach the Vulkan queue, not for the GPU to finish it
+            g_D3DVR9->LockSubmissionQueue(sequenceNumber);
+            vr::VRCompositor()->Submit(vr::Eye_Left, &textures[vr::Eye_Left], &bounds[vr::Eye_Left], flags[vr::Eye_Left]);
+            vr::VRCompositor()->Submit(vr::Eye_Right, &textures[vr::Eye_Right], &bounds[vr::Eye_Right], flags[vr::Eye_Right]);
+            if (submitHud)
+                m_HudCompositor.SetTexture(m_VKHUD.m_VRTexture);
+            g_D3DVR9->UnlockSubmissionQueue();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_SubmitLock);
+            m_SubmitPending = false;
+        }
+        m_SubmitCondition.notify_all();
+    }
+}
+
+// Called from the HUD pass of every frame. Returns true if it should repaint m_HUDTexture, see HudCompositor.
+bool VR::BeginHudPaint()
+{
+    if (!m_HUDTexture || !m_HudCompositor.BeginPaint(m_HudUpdateRate))
+        return false;
+
+    // The last repaint may still be waiting for the submit thread to hand it to the overlay
+    if (m_SubmitHud)
+        WaitForAsyncSubmit();
+
+    return true;
+}
+
+// Whether the right eye skips the passes that look the same from both eyes, a running benchmark decides for itself
+bool VR::UseSharedEyePasses() const
+{
+    return m_StereoBenchmark.IsRunning() ? m_StereoBenchmark.SharedPasses() : m_SharedEyePasses;
+}
+
+void VR::EndStereoBenchmarkFrame(uint64_t eyesNanoseconds)
+{
+    if (!m_StereoBenchmark.AddFrame(eyesNanoseconds))
+        return;
+
+    const auto print = [](const char *name, const StereoBenchmark::Result &result)
+    {
+        std::cout << "Stereo benchmark: " << name << ": mean " << result.m_MeanMs << " ms, p50 " << result.m_P50Ms
+            << " ms, p95 " << result.m_P95Ms << " ms over " << result.m_Frames << " frames\n";
+    };
+
+    const StereoBenchmark::Result separate = m_StereoBenchmark.GetResult(false);
+    const StereoBenchmark::Result shared = m_StereoBenchmark.GetResult(true);
+    print("separate passes", separate);
+    print("shared passes  ", shared);
+    if (separate.m_MeanMs > 0.0)
+        std::cout << "Stereo benchmark: shared passes take " << 100.0 * shared.m_MeanMs / separate.m_MeanMs << "% of the time\n";
+}
+
+// The current set's texture for 'eye'. With depth submission on, the depth buffer and the pose it was rendered
+// with are filled in as well and the returned flags tell the compositor to use them.
+vr::EVRSubmitFlags VR::GetSubmitTexture(vr::EVREye eye, vr::VRTextureWithPoseAndDepth_t &textureOut)
+{
+    const EyeTextureSet &set = m_EyeTextureSets[m_EyeTextureSetIndex];
+    textureOut = {};
+    static_cast<vr::Texture_t &>(textureOut) = (eye == vr::Eye_Left ? set.m_VKLeftEye : set.m_VKRightEye).m_VRTexture;
+
+    if (!m_SubmitDepth || !set.m_D9LeftEyeDepthSurface || !set.m_D9RightEyeDepthSurface || set.m_RenderZFar <= set.m_RenderZNear)
+        return vr::Submit_Default;
+
+    const SharedTextureHolder &depth = eye == vr::Eye_Left ? set.m_VKLeftEyeDepth : set.m_VKRightEyeDepth;
+    textureOut.mDeviceToAbsoluteTracking = set.m_RenderPose;
+    textureOut.depth.handle = (void *)&depth.m_VulkanData;
+
+    // Source renders with a regular 0..1 depth range, its clip planes are in game units
+    textureOut.depth.mProjection = m_System->GetProjectionMatrix(eye, set.m_RenderZNear / m_VRScale, set.m_RenderZFar / m_VRScale);
+    textureOut.depth.vRange = { 0.0f, 1.0f };
+
+    return (vr::EVRSubmitFlags)(vr::Submit_TextureWithPose | vr::Submit_TextureWithDepth);
+}
+
+// m_TextureBounds mapped to the part of the eye texture that was actually rendered this frame
+vr::VRTextureBounds_t VR::GetSubmitBounds(vr::EVREye eye)
+{
+    vr::VRTextureBounds_t bounds = m_TextureBounds[eye];
+
+    bounds.uMin = bounds.uMin * m_ViewportWidth / m_EyeTextureWidth;
+    bounds.uMax = bounds.uMax * m_ViewportWidth / m_EyeTextureWidth;
+    bounds.vMin = bounds.vMin * m_ViewportHeight / m_EyeTextureHeight;
+    bounds.vMax = bounds.vMax * m_ViewportHeight / m_EyeTextureHeight;
+
+    return bounds;
+}
+
+void VR::UpdateDynamicResolution()
+{
+    if (!m_DynamicResolution)
+    {
+        m_ResolutionScale = 1.0f;
+        return;
+    }
+
+    vr::Compositor_FrameTiming timing = {};
+    timing.m_nSize = sizeof(vr::Compositor_FrameTiming);
+    if (!vr::VRCompositor()->GetFrameTiming(&timing, 0))
+        return;
+
+    float targetMs = m_DynamicResolutionTargetMs > 0 ? m_DynamicResolutionTargetMs : 0.9f * 1000.0f / m_DisplayFrequency;
+
+    // Smooth out single frame spikes (loading, shader compiles) so they don't drag the resolution down
+    m_GpuFrameTimeAvg = m_GpuFrameTimeAvg * 0.9f + timing.m_flTotalRenderGpuMs * 0.1f;
+    float cpuFrameMs = timing.m_flNewFrameReadyMs - timing.m_flNewPosesReadyMs;
+
+    // Give the new scale a few frames to show up in the timings before changing it again
+    if (m_ResolutionCooldown > 0)
+    {
+        --m_ResolutionCooldown;
+        return;
+    }
+
+    float scale = m_ResolutionScale;
+
+    // When the CPU alone is over budget a lower resolution won't help
+    if (m_GpuFrameTimeAvg > targetMs * (1.0f + m_DynamicResolutionHysteresis) && cpuFrameMs < targetMs)
+        scale -= 0.05f;
+    else if (m_GpuFrameTimeAvg < targetMs * (1.0f - m_DynamicResolutionHysteresis))
+        scale += 0.05f;
+
+    scale = std::clamp(scale, m_DynamicResolutionMinScale, std::max(m_DynamicResolutionMinScale, m_DynamicResolutionMaxScale));
+
+    if (scale != m_ResolutionScale)
+    {
+        m_ResolutionScale = scale;
+        m_ResolutionCooldown = 10;
+    }
+}
+
+// Crops the left eye image to the window's aspect ratio and stretches it into the backbuffer,
+// much cheaper than rendering the scene a third time just for the desktop window
+void VR::MirrorToWindow()
+{
+    if (!m_D9LeftEyeSurface)
+        return;
+
+    const int windowWidth = m_FrameState.m_WindowWidth;
+    const int windowHeight = m_FrameState.m_WindowHeight;
+
+    if (windowWidth <= 0 || windowHeight <= 0)
+        return;
+
+    // Only use the part of the texture that's actually visible in the HMD
+    float srcX = m_TextureBounds[0].uMin * m_ViewportWidth;
+    float srcY = m_TextureBounds[0].vMin * m_ViewportHeight;
+    float srcWidth = (m_TextureBounds[0].uMax - m_TextureBounds[0].uMin) * m_ViewportWidth;
+    float srcHeight = (m_TextureBounds[0].vMax - m_TextureBounds[0].vMin) * m_ViewportHeight;
+
+    float windowAspect = (float)windowWidth / windowHeight;
+    if (srcWidth / srcHeight > windowAspect)
+    {
+        float croppedWidth = srcHeight * windowAspect;
+        srcX += (srcWidth - croppedWidth) / 2;
+        srcWidth = croppedWidth;
+    }
+    else
+    {
+        float croppedHeight = srcWidth / windowAspect;
+        srcY += (srcHeight - croppedHeight) / 2;
+        srcHeight = croppedHeight;
+    }
+
+    RECT srcRect = { (LONG)srcX, (LONG)srcY, (LONG)(srcX + srcWidth), (LONG)(srcY + srcHeight) };
+
+    IDirect3DDevice9 *device = nullptr;
+    if (FAILED(m_D9LeftEyeSurface->GetDevice(&device)))
+        return;
+
+    IDirect3DSurface9 *backBuffer = nullptr;
+    if (SUCCEEDED(device->GetBackBuffer(0, 0, D3DBACKBUFFER_TYPE_MONO, &backBuffer)))
+    {
+        device->StretchRect(m_D9LeftEyeSurface, &srcRect, backBuffer, NULL, D3DTEXF_LINEAR);
+        backBuffer->Release();
+    }
+
+    device->Release();
+}
+
 void VR::GetPoseData(vr::TrackedDevicePose_t &poseRaw, TrackedDevicePoseData &poseOut)
 {
     if (poseRaw.bPoseIsValid) 
@@ -346,14 +906,11 @@ void VR::GetPoseData(vr::TrackedDevicePose_t &poseRaw, TrackedDevicePoseData &po
 
 void VR::RepositionOverlays()
 {
-    vr::TrackedDevicePose_t hmdPose = m_Poses[vr::k_unTrackedDeviceIndex_Hmd];
+    vr::TrackedDevicePose_t hmdPose = m_InputSource.Pose(vr::k_unTrackedDeviceIndex_Hmd);
     vr::HmdMatrix34_t hmdMat = hmdPose.mDeviceToAbsoluteTracking;
     Vector hmdPosition = { hmdMat.m[0][3], hmdMat.m[1][3], hmdMat.m[2][3] };
     Vector hmdForward = { -hmdMat.m[0][2], 0, -hmdMat.m[2][2] };
 
-    int windowWidth, windowHeight;
-    m_Game->m_MaterialSystem->GetRenderContext()->GetWindowSize(windowWidth, windowHeight);
-
     vr::HmdMatrix34_t menuTransform = 
     {
         1.0f, 0.0f, 0.0f, 0.0f,
@@ -367,8 +924,8 @@ void VR::RepositionOverlays()
     float renderWidth = m_VKBackBuffer.m_VulkanData.m_nWidth;
     float renderHeight = m_VKBackBuffer.m_VulkanData.m_nHeight;
 
-    float widthRatio = windowWidth / renderWidth;
-    float heightRatio = windowHeight / renderHeight;
+    float widthRatio = m_FrameState.m_WindowWidth / renderWidth;
+    float heightRatio = m_FrameState.m_WindowHeight / renderHeight;
     menuTransform.m[0][0] *= widthRatio;
     menuTransform.m[1][1] *= heightRatio;
 
@@ -394,7 +951,7 @@ void VR::RepositionOverlays()
     vr::VROverlay()->SetOverlayWidthInMeters(m_MainMenuHandle, 1.5 * (1.0 / heightRatio));
 
     // Reposition HUD overlay
-    /*vr::HmdMatrix34_t hudTransform =
+    vr::HmdMatrix34_t hudTransform =
     {
         1.0f, 0.0f, 0.0f, 0.0f,
         0.0f, 1.0f, 0.0f, 0.0f,
@@ -413,23 +970,37 @@ void VR::RepositionOverlays()
     hudTransform.m[2][0] = -sin(hmdRotationDegrees);
     hudTransform.m[2][2] *= cos(hmdRotationDegrees);
 
-    vr::VROverlay()->SetOverlayTransformAbsolute(m_HUDHandle, trackingOrigin, &hudTransform);
-    vr::VROverlay()->SetOverlayWidthInMeters(m_HUDHandle, m_HudSize);*/
+    vr::VROverlay()->SetOverlayTransformAbsolute(m_HudCompositor.Handle(), trackingOrigin, &hudTransform);
+    vr::VROverlay()->SetOverlayWidthInMeters(m_HudCompositor.Handle(), m_HudSize);
 }
 
 void VR::GetPoses() 
 {
-    vr::TrackedDevicePose_t hmdPose = m_Poses[vr::k_unTrackedDeviceIndex_Hmd];
+    float hmdHorizon = 0.0f;
+    float controllerHorizon = 0.0f;
+
+    if (m_PosePrediction)
+    {
+        // The poses are already predicted to the photons of the frame they were fetched for. Only extrapolate
+        // by how much later the photons of the frame being rendered now are, e.g. after missing a vsync.
+        float poseAge = m_InputSource.GetPoseAge();
 
-    vr::TrackedDeviceIndex_t leftControllerIndex = m_System->GetTrackedDeviceIndexForControllerRole(vr::TrackedControllerRole_LeftHand);
-    vr::TrackedDeviceIndex_t rightControllerIndex = m_System->GetTrackedDeviceIndexForControllerRole(vr::TrackedControllerRole_RightHand);
+        hmdHorizon = std::clamp(poseAge + m_HmdPredictionMs / 1000.0f, 0.0f, MAX_PREDICTION_SECONDS);
+        controllerHorizon = std::clamp(poseAge + m_ControllerPredictionMs / 1000.0f, 0.0f, MAX_PREDICTION_SECONDS);
+    }
+
+    vr::TrackedDevicePose_t hmdPose = PredictPose(m_InputSource.Pose(vr::k_unTrackedDeviceIndex_Hmd), hmdHorizon);
+
+    vr::TrackedDeviceIndex_t leftControllerIndex, rightControllerIndex;
+    m_InputSource.GetControllerIndices(leftControllerIndex, rightControllerIndex);
 
     if (m_LeftHanded)
         std::swap(leftControllerIndex, rightControllerIndex);
 
-    vr::TrackedDevicePose_t leftControllerPose = m_Poses[leftControllerIndex];
-    vr::TrackedDevicePose_t rightControllerPose = m_Poses[rightControllerIndex];
+    vr::TrackedDevicePose_t leftControllerPose = PredictPose(m_InputSource.Pose(leftControllerIndex), controllerHorizon);
+    vr::TrackedDevicePose_t rightControllerPose = PredictPose(m_InputSource.Pose(rightControllerIndex), controllerHorizon);
 
+    m_HmdPoseMatrix = hmdPose.mDeviceToAbsoluteTracking;
     GetPoseData(hmdPose, m_HmdPose);
     GetPoseData(leftControllerPose, m_LeftControllerPose);
     GetPoseData(rightControllerPose, m_RightControllerPose);
@@ -437,8 +1008,34 @@ void VR::GetPoses()
 
 void VR::UpdatePosesAndActions() 
 {
-    vr::VRCompositor()->WaitGetPoses(m_Poses, vr::k_unMaxTrackedDeviceCount, NULL, 0);
-    m_Input->UpdateActionState(&m_ActiveActionSet, sizeof(vr::VRActiveActionSet_t), 1);
+    TIME_SCOPE(Timing_WaitGetPoses);
+    m_InputSource.BeginFrame(m_ActiveActionSet);
+}
+
+// Samples poses for the late latch in dRenderView
+void VR::TrackPoses()
+{
+    while (1)
+    {
+        if (!m_TrackingThread || !m_IsVREnabled)
+        {
+            Sleep(100);
+            continue;
+        }
+
+        m_InputSource.SamplePoses();
+        Sleep(1);
+    }
+}
+
+// Swaps in the poses the tracking thread sampled since UpdatePosesAndActions. Returns false if there are none newer.
+bool VR::LatchPoses()
+{
+    // Replay latches wherever the recorded session did
+    if (!m_TrackingThread && !m_InputSource.Recording().IsReplaying())
+        return false;
+
+    return m_InputSource.LatchPoses();
 }
 
 void VR::GetViewParameters() 
@@ -456,31 +1053,20 @@ void VR::GetViewParameters()
 
 bool VR::CheckDigitalActionChanged(vr::VRActionHandle_t &actionHandle, bool &state)
 {
-    vr::InputDigitalActionData_t digitalActionData;
-    vr::EVRInputError result = m_Input->GetDigitalActionData(actionHandle, &digitalActionData, sizeof(digitalActionData), vr::k_ulInvalidInputValueHandle);
-    
-    if (result == vr::VRInputError_None)
-    {
-        state = digitalActionData.bState;
-        return digitalActionData.bChanged;
-    }
-
-    state = false;
-    return false;
+    bool changed = false;
+    m_InputSource.GetDigitalAction(actionHandle, state, changed);
+    return changed;
 }
 
 bool VR::GetAnalogActionData(vr::VRActionHandle_t &actionHandle, vr::InputAnalogActionData_t &analogDataOut)
 {
-    vr::EVRInputError result = m_Input->GetAnalogActionData(actionHandle, &analogDataOut, sizeof(analogDataOut), vr::k_ulInvalidInputValueHandle);
-
-    if (result == vr::VRInputError_None)
-        return true;
-
-    return false;
+    return m_InputSource.GetAnalogAction(actionHandle, analogDataOut);
 }
 
 void VR::ProcessMenuInput()
 {
+    TIME_SCOPE(Timing_ProcessInput);
+
     //vr::VROverlayHandle_t currentOverlay = m_Game->m_EngineClient->IsInGame() ? m_HUDHandle : m_MainMenuHandle;
     vr::VROverlayHandle_t currentOverlay = m_MainMenuHandle;
 
@@ -494,8 +1080,8 @@ void VR::ProcessMenuInput()
     {
         vr::VROverlay()->SetOverlayFlag(currentOverlay, vr::VROverlayFlags_MakeOverlaysInteractiveIfVisible, true);
 
-        int windowWidth, windowHeight;
-        m_Game->m_MaterialSystem->GetRenderContext()->GetWindowSize(windowWidth, windowHeight);
+        const int windowWidth = m_FrameState.m_WindowWidth;
+        const int windowHeight = m_FrameState.m_WindowHeight;
 
         vr::VREvent_t vrEvent;
         while (vr::VROverlay()->PollNextOverlayEvent(currentOverlay, &vrEvent, sizeof(vrEvent)))
@@ -508,7 +1094,7 @@ void VR::ProcessMenuInput()
                 float laserX = vrEvent.data.mouse.x;
                 float laserY = vrEvent.data.mouse.y;
 
-                if (m_Game->m_EngineClient->IsInGame())
+                if (m_FrameState.m_IsInGame)
                 {
                     laserY -= (m_RenderHeight - windowHeight);
                     laserY = windowHeight - laserY;
@@ -616,6 +1202,8 @@ void VR::ProcessMenuInput()
 
 void VR::ProcessInput()
 {
+    TIME_SCOPE(Timing_ProcessInput);
+
     if (!m_IsVREnabled)
         return;
 
@@ -627,6 +1215,8 @@ void VR::ProcessInput()
     float deltaTime = elapsed.count();
     m_PrevFrameTime = currentTime;
 
+    deltaTime = m_InputSource.GetFrameDelta(deltaTime);
+
     vr::InputAnalogActionData_t analogActionData;
 
     if (GetAnalogActionData(m_ActionTurn, analogActionData))
@@ -756,24 +1346,21 @@ void VR::ProcessInput()
         m_Game->ClientCmd_Unrestricted("impulse 201");
     }
     
-    /*bool isControllerVertical = m_RightControllerAngAbs.x > 60 || m_RightControllerAngAbs.x < -45;
-    if ((PressedDigitalAction(m_ShowHUD) || PressedDigitalAction(m_Scoreboard) || isControllerVertical || m_HudAlwaysVisible)
-        && m_RenderedHud)
+    // The HUD is only painted while its overlay is wanted, see HudCompositor
+    bool showHud = false;
+    CheckDigitalActionChanged(m_ShowHUD, showHud);
+    bool isControllerVertical = m_RightControllerAngAbs.x > 60 || m_RightControllerAngAbs.x < -45;
+    if ((showHud || isControllerVertical || m_HudAlwaysVisible) && m_HudOverlay && m_HudOverlayActive && m_RenderedHud)
     {
-        if (!vr::VROverlay()->IsOverlayVisible(m_HUDHandle) || m_HudAlwaysVisible)
+        if (!m_HudCompositor.IsWanted() || m_HudAlwaysVisible)
             RepositionOverlays();
 
-        if (PressedDigitalAction(m_Scoreboard))
-            m_Game->ClientCmd_Unrestricted("+showscores");
-        else
-            m_Game->ClientCmd_Unrestricted("-showscores");
-
-        vr::VROverlay()->ShowOverlay(m_HUDHandle);
+        m_HudCompositor.SetWanted(true);
     }
     else
     {
-        vr::VROverlay()->HideOverlay(m_HUDHandle);
-    }*/
+        m_HudCompositor.SetWanted(false);
+    }
 
     m_RenderedHud = false;
 
@@ -844,7 +1431,7 @@ bool VR::CheckOverlayIntersectionForController(vr::VROverlayHandle_t overlayHand
     if (deviceIndex == vr::k_unTrackedDeviceIndexInvalid)
         return false;
 
-    vr::TrackedDevicePose_t &controllerPose = m_Poses[deviceIndex];
+    const vr::TrackedDevicePose_t &controllerPose = m_InputSource.Pose(deviceIndex);
 
     if (!controllerPose.bPoseIsValid)
         return false;
@@ -896,6 +1483,51 @@ Vector VR::GetRightControllerAbsPos(Vector eyePosition)
     return position;
 }
 
+// Extrapolates the right controller 'seconds' ahead of the last tracking update
+// The VR data sent to the server with every usercmd
+void VR::GetUsercmdPayload(VRUsercmdPayload &payload)
+{
+    // Send where the hand will be by the time the server processes this command
+    Vector controllerPos;
+    QAngle controllerAngles;
+    PredictRightController(m_UsercmdPredictionMs / 1000.0f, controllerPos, controllerAngles);
+    payload.SetPose(VRDevice_RightController, controllerPos, controllerAngles);
+
+    Vector leftControllerPos = m_SetupOrigin + m_LeftControllerPosRel;
+    if (m_6DOF)
+        leftControllerPos += m_HmdPosRelative;
+    payload.SetPose(VRDevice_LeftController, leftControllerPos, m_LeftControllerAngAbs);
+
+    payload.SetPose(VRDevice_Hmd, GetViewOrigin(m_SetupOrigin), m_HmdAngAbs);
+}
+
+void VR::PredictRightController(float seconds, Vector &posOut, QAngle &angOut)
+{
+    // Velocities are in tracking space, turn them the same way UpdateTracking turns the controller
+    Vector velocity = m_RightControllerPose.TrackedDeviceVel;
+    VectorPivotXY(velocity, { 0, 0, 0 }, m_RotationOffset.y);
+
+    posOut = GetRightControllerAbsPos() + velocity * (m_VRScale * seconds);
+
+    const QAngle &angVelRaw = m_RightControllerPose.TrackedDeviceAngVel;
+    Vector angVelocity = { angVelRaw.x, angVelRaw.y, angVelRaw.z };
+    VectorPivotXY(angVelocity, { 0, 0, 0 }, m_RotationOffset.y);
+
+    Vector forward = m_RightControllerForward;
+    Vector up = m_RightControllerUp;
+
+    float angSpeed = VectorLength(angVelocity);
+    if (angSpeed * seconds > 0.001f)
+    {
+        Vector axis = angVelocity * (1.0f / angSpeed);
+        forward = VectorRotate(forward, axis, angSpeed * seconds);
+        up = VectorRotate(up, axis, angSpeed * seconds);
+    }
+
+    QAngle::VectorAngles(forward, up, angOut);
+    angOut.Normalize();
+}
+
 Vector VR::GetRecommendedViewmodelAbsPos(Vector eyePosition)
 {
     Vector viewmodelPos = GetRightControllerAbsPos(eyePosition);
@@ -940,16 +1572,8 @@ void VR::ResetPosition()
         m_Center.z = 0;
 }
 
-void VR::UpdateTracking()
+void VR::UpdateHMDTracking()
 {
-    GetPoses();
-
-    int playerIndex = m_Game->m_EngineClient->GetLocalPlayer();
-    C_BasePlayer* localPlayer = (C_BasePlayer*)m_Game->GetClientEntity(playerIndex);
-    if (!localPlayer)
-        return;
-
-    // HMD tracking
     Vector hmdPosLocal = m_HmdPose.TrackedDevicePos;
     Vector hmdPosCentered = hmdPosLocal - m_Center;
 
@@ -967,6 +1591,20 @@ void VR::UpdateTracking()
         // 64 is the eye view height from the player's base position
         // we subtract this here so that we place the HMD height at the actual player height if 6DOF is enabled
         m_HmdPosRelative.z -= 64;
+}
+
+void VR::UpdateTracking()
+{
+    TIME_SCOPE(Timing_UpdateTracking);
+
+    GetPoses();
+
+    C_BasePlayer* localPlayer = m_Game->m_LocalPlayer;
+    if (!localPlayer)
+        return;
+
+    // HMD tracking
+    UpdateHMDTracking();
 
     // Roomscale setup
     /*Vector cameraMovingDirection = m_Center - m_SetupOriginPrev;
@@ -1048,7 +1686,7 @@ void VR::UpdateTracking()
 
     //std::cout << "Right Controller - X: " << rightControllerPosLocal.x << "Y: " << rightControllerPosLocal.y << "Z: " << rightControllerPosLocal.z << "\n";
 
-    Vector hmdToController = rightControllerPosLocal - hmdPosLocal;
+    Vector hmdToController = rightControllerPosLocal - m_HmdPose.TrackedDevicePos;
     //Vector rightControllerPosCorrected = hmdPosCorrected + hmdToController;
 
     // When using stick turning, pivot the controllers around the HMD
@@ -1056,6 +1694,10 @@ void VR::UpdateTracking()
 
     m_RightControllerPosRel = hmdToController * m_VRScale;
 
+    Vector hmdToLeftController = leftControllerPosLocal - m_HmdPose.TrackedDevicePos;
+    VectorPivotXY(hmdToLeftController, { 0, 0, 0 }, m_RotationOffset.y);
+    m_LeftControllerPosRel = hmdToLeftController * m_VRScale;
+
     //rightControllerAngLocal += m_RotationOffset;
     rightControllerAngLocal.x += m_RotationOffset.x;
     rightControllerAngLocal.y += m_RotationOffset.y;
@@ -1135,7 +1777,11 @@ Vector VR::GetViewOriginRight(Vector setupOrigin)
     return viewOriginRight;
 }
 
+// Aim laser end point, traced once per frame
 Vector VR::Trace(uint32_t* localPlayer) {
+    if (m_TraceCache.m_AimFrame == m_FrameNumber)
+        return m_TraceCache.m_AimPos;
+
     Vector vecStart = GetRightControllerAbsPos();
     Vector vecEnd = vecStart + m_RightControllerForward * MAX_TRACE_LENGTH;
 
@@ -1147,6 +1793,8 @@ Vector VR::Trace(uint32_t* localPlayer) {
 
     m_Game->m_EngineTrace->TraceRay(ray, MASK_SHOT | MASK_SHOT_HULL, &tracefilter, &trace);
 
+    m_TraceCache.m_AimFrame = m_FrameNumber;
+    m_TraceCache.m_AimPos = trace.endpos;
     return trace.endpos;
 }
 
@@ -1294,7 +1942,12 @@ QAngle TransformAnglesToWorldSpace(const QAngle& angles, const matrix3x4_t& pare
 }
 
 
-Vector VR::TraceEye(uint32_t* localPlayer, Vector cameraPos, Vector eyePos, QAngle& eyeAngle) {
+// Moves an eye that ended up behind a wall (the camera is at the player's head, the HMD can be a bit off)
+// through the portal in that wall, if there is one. 'portalHint' is tried before searching all portals
+// and receives the portal that was used.
+Vector VR::TraceEye(uint32_t* localPlayer, Vector cameraPos, Vector eyePos, QAngle& eyeAngle, CPortal_Base2D **portalHint) {
+    TIME_SCOPE(Timing_TraceEye);
+
     CGameTrace trTestObstructionsNearPortals;
     Ray_t ray;
     CTraceFilterSkipNPCsAndPlayers tracefilter((IHandleEntity*)localPlayer, 0);
@@ -1302,11 +1955,31 @@ Vector VR::TraceEye(uint32_t* localPlayer, Vector cameraPos, Vector eyePos, QAng
     ray.Init(cameraPos, eyePos);
     m_Game->m_EngineTrace->TraceRay(ray, MASK_SHOT | MASK_SHOT_HULL, &tracefilter, &trTestObstructionsNearPortals);
 
+    if (!trTestObstructionsNearPortals.DidHit())
+        return eyePos;
+
     float flWallHitFraction = trTestObstructionsNearPortals.fraction + 0.01f;
-    CPortal_Base2D* pPortal = (CPortal_Base2D*)m_Game->m_Hooks->UTIL_Portal_FirstAlongRay(ray, flWallHitFraction);
+    CPortal_Base2D* pPortal = nullptr;
+    float flRayHitFraction = -1.0f;
+
+    if (portalHint && *portalHint)
+    {
+        flRayHitFraction = m_Game->m_Hooks->UTIL_IntersectRayWithPortal(ray, *portalHint);
+        if (flRayHitFraction >= 0.0f && flRayHitFraction < flWallHitFraction)
+            pPortal = *portalHint;
+    }
 
-    if (trTestObstructionsNearPortals.DidHit() && pPortal) {
-        float flRayHitFraction = m_Game->m_Hooks->UTIL_IntersectRayWithPortal(ray, pPortal);
+    if (!pPortal)
+    {
+        pPortal = (CPortal_Base2D*)m_Game->m_Hooks->UTIL_Portal_FirstAlongRay(ray, flWallHitFraction);
+        if (pPortal)
+            flRayHitFraction = m_Game->m_Hooks->UTIL_IntersectRayWithPortal(ray, pPortal);
+    }
+
+    if (portalHint && pPortal)
+        *portalHint = pPortal;
+
+    if (pPortal) {
         //Vector vNewEye;
         Vector vHitPoint = ray.m_Start + ray.m_Delta * flRayHitFraction;
         //vNewEye = m_Game->m_Hooks->UTIL_Portal_PointTransform(pPortal->MatrixThisToLinked(), vHitPoint, vNewEye);
@@ -1327,6 +2000,60 @@ Vector VR::TraceEye(uint32_t* localPlayer, Vector cameraPos, Vector eyePos, QAng
     return eyePos;
 }
 
+// Origins and angles of both eyes for this frame. The two eye rays are only an IPD apart, so a single
+// box swept from the camera to the midpoint between the eyes, wide enough to contain both rays, is traced
+// first. Nothing in the way (the usual case) means neither eye needs to move and we're done after one trace.
+// Otherwise each eye is traced on its own, the second one trying the portal the first one found first.
+void VR::ResolveEyeOrigins(uint32_t* localPlayer, const Vector &cameraPos, const QAngle &angles, Vector &leftOrigin, QAngle &leftAngles, Vector &rightOrigin, QAngle &rightAngles)
+{
+    FrameTraceCache &cache = m_TraceCache;
+
+    if (cache.m_EyeFrame != m_FrameNumber || (cache.m_EyeCameraPos - cameraPos).LengthSqr() != 0 || cache.m_EyeInputAngles != angles)
+    {
+        cache.m_EyeFrame = m_FrameNumber;
+        cache.m_EyeCameraPos = cameraPos;
+        cache.m_EyeInputAngles = angles;
+
+        const Vector eyePos[2] = { GetViewOriginLeft(cameraPos), GetViewOriginRight(cameraPos) };
+        const Vector eyeCenter = (eyePos[0] + eyePos[1]) * 0.5f;
+        const Vector halfIpd = eyePos[1] - eyeCenter;
+        const Vector extents(fabsf(halfIpd.x), fabsf(halfIpd.y), fabsf(halfIpd.z));
+
+        CGameTrace trace;
+        Ray_t ray;
+        CTraceFilterSkipNPCsAndPlayers tracefilter((IHandleEntity*)localPlayer, 0);
+
+        ray.Init(cameraPos, eyeCenter, -extents, extents);
+        {
+            TIME_SCOPE(Timing_TraceEye);
+            m_Game->m_EngineTrace->TraceRay(ray, MASK_SHOT | MASK_SHOT_HULL, &tracefilter, &trace);
+        }
+
+        if (!trace.DidHit())
+        {
+            for (int eye = 0; eye < 2; ++eye)
+            {
+                cache.m_EyeOrigins[eye] = eyePos[eye];
+                cache.m_EyeAngles[eye] = angles;
+            }
+        }
+        else
+        {
+            CPortal_Base2D *portal = nullptr;
+            for (int eye = 0; eye < 2; ++eye)
+            {
+                cache.m_EyeAngles[eye] = angles;
+                cache.m_EyeOrigins[eye] = TraceEye(localPlayer, cameraPos, eyePos[eye], cache.m_EyeAngles[eye], &portal);
+            }
+        }
+    }
+
+    leftOrigin = cache.m_EyeOrigins[0];
+    leftAngles = cache.m_EyeAngles[0];
+    rightOrigin = cache.m_EyeOrigins[1];
+    rightAngles = cache.m_EyeAngles[1];
+}
+
 // [CONFIG PARSING UTILITY FUNCTION]
 // Generates an error message by stringifying and concatenating 'args...'.
 template <typename... Ts>
@@ -1386,9 +2113,9 @@ catch (const std::logic_error& e)
     throw;
 }
 
-void VR::ParseConfigFile()
+std::shared_ptr<VRSettings> VR::ParseConfigFile(const std::string &config)
 {
-    std::ifstream configStream("VR\\config.txt");
+    std::istringstream configStream(config);
     std::unordered_map<std::string, std::string> userConfig;
 
     std::string line;
@@ -1407,7 +2134,9 @@ void VR::ParseConfigFile()
     }
 
     if (userConfig.empty())
-        return;
+        return nullptr;
+
+    auto settings = std::make_shared<VRSettings>();
 
     // Parse a single entry with key 'key' from the config into 'target'.
     // If the entry does not exist, or if the parsing fails, sets 'target' to
@@ -1430,65 +2159,150 @@ void VR::ParseConfigFile()
         parseOrDefault((keyPrefix + "Z").c_str(), target.z, 0.f);
     };
 
-    parseOrDefault("SnapTurning", m_SnapTurning, true);
-    parseOrDefault("SnapTurnAngle", m_SnapTurnAngle, 45.0f);
-    parseOrDefault("TurnSpeed", m_TurnSpeed, 0.15f);
-    parseOrDefault("LeftHanded", m_LeftHanded, false);
-    parseOrDefault("VRScale", m_VRScale, 43.2f);
-    parseOrDefault("IPDScale", m_IpdScale, 1.0f);
-    parseOrDefault("6DOF", m_6DOF, true);
-    parseOrDefault("SeatedMode", m_SeatedMode, false);
-    /*parseOrDefault("HudDistance", m_HudDistance, 1.3f);
-    parseOrDefault("HudSize", m_HudSize, 4.0f);
-    parseOrDefault("HudAlwaysVisible", m_HudAlwaysVisible, false);*/
-    parseOrDefault("AimMode", m_AimMode, 2);
-    parseOrDefault("AntiAliasing", m_AntiAliasing, 0);
-    parseOrDefault("RenderWindow", m_RenderWindow, 0);
-    parseXYZOrDefaultZero("ViewmodelPosCustomOffset", m_ViewmodelPosCustomOffset);
-    parseXYZOrDefaultZero("ViewmodelAngCustomOffset", m_ViewmodelAngCustomOffset);
-    parseOrDefault("PortallingDetectionDistanceThreshold", m_PortallingDetectionDistanceThreshold, 35);
-    parseOrDefault("ApplyPitchAndRollPortalRotationOffset", m_ApplyPitchAndRollPortalRotationOffset, false);
-    parseOrDefault("CameraUprightRecoverySpeed", m_CameraUprightRecoverySpeed, 0.2f);
+    parseOrDefault("SnapTurning", settings->m_SnapTurning, true);
+    parseOrDefault("SnapTurnAngle", settings->m_SnapTurnAngle, 45.0f);
+    parseOrDefault("TurnSpeed", settings->m_TurnSpeed, 0.15f);
+    parseOrDefault("LeftHanded", settings->m_LeftHanded, false);
+    parseOrDefault("VRScale", settings->m_VRScale, 43.2f);
+    parseOrDefault("IPDScale", settings->m_IpdScale, 1.0f);
+    parseOrDefault("6DOF", settings->m_6DOF, true);
+    parseOrDefault("SeatedMode", settings->m_SeatedMode, false);
+    parseOrDefault("HudOverlay", settings->m_HudOverlay, false);
+    parseOrDefault("HudDistance", settings->m_HudDistance, 1.3f);
+    parseOrDefault("HudSize", settings->m_HudSize, 4.0f);
+    parseOrDefault("HudAlwaysVisible", settings->m_HudAlwaysVisible, false);
+    parseOrDefault("HudUpdateRate", settings->m_HudUpdateRate, 30.0f);
+    parseOrDefault("AimMode", settings->m_AimMode, 2);
+    parseOrDefault("AntiAliasing", settings->m_AntiAliasing, 0);
+    parseOrDefault("RenderWindow", settings->m_RenderWindow, 0);
+    parseXYZOrDefaultZero("ViewmodelPosCustomOffset", settings->m_ViewmodelPosCustomOffset);
+    parseXYZOrDefaultZero("ViewmodelAngCustomOffset", settings->m_ViewmodelAngCustomOffset);
+    parseOrDefault("PortallingDetectionDistanceThreshold", settings->m_PortallingDetectionDistanceThreshold, 35);
+    parseOrDefault("ApplyPitchAndRollPortalRotationOffset", settings->m_ApplyPitchAndRollPortalRotationOffset, false);
+    parseOrDefault("CameraUprightRecoverySpeed", settings->m_CameraUprightRecoverySpeed, 0.2f);
+    parseOrDefault("TrackingThread", settings->m_TrackingThread, false);
+    parseOrDefault("SharedEyePasses", settings->m_SharedEyePasses, false);
+    parseOrDefault("StereoBenchmark", settings->m_RunStereoBenchmark, false);
+    parseOrDefault("EyeTextureBuffers", settings->m_EyeTextureBuffers, 2);
+    parseOrDefault("AsyncSubmit", settings->m_AsyncSubmit, false);
+    parseOrDefault("SubmitDepth", settings->m_SubmitDepth, false);
+    parseOrDefault("PipelineWarmUp", settings->m_PipelineWarmUp, false);
+    parseOrDefault("PipelineWarmUpThreads", settings->m_PipelineWarmUpThreads, 2);
+    parseOrDefault("PipelineWarmUpBudgetMs", settings->m_PipelineWarmUpBudgetMs, 3000.0f);
+    parseOrDefault("InputRecording", settings->m_InputRecordingMode, 0);
+    parseOrDefault("FrameTiming", settings->m_FrameTiming, false);
+    parseOrDefault("DynamicResolution", settings->m_DynamicResolution, false);
+    parseOrDefault("DynamicResolutionMinScale", settings->m_DynamicResolutionMinScale, 0.6f);
+    parseOrDefault("DynamicResolutionMaxScale", settings->m_DynamicResolutionMaxScale, 1.0f);
+    parseOrDefault("DynamicResolutionTargetMs", settings->m_DynamicResolutionTargetMs, 0.0f);
+    parseOrDefault("DynamicResolutionHysteresis", settings->m_DynamicResolutionHysteresis, 0.1f);
+    parseOrDefault("PosePrediction", settings->m_PosePrediction, false);
+    parseOrDefault("HmdPredictionMs", settings->m_HmdPredictionMs, 0.0f);
+    parseOrDefault("ControllerPredictionMs", settings->m_ControllerPredictionMs, 0.0f);
+    parseOrDefault("UsercmdPredictionMs", settings->m_UsercmdPredictionMs, 20.0f);
+
+    ValidateSettings(*settings);
+    return settings;
+}
+
+// Clamps values that would otherwise break tracking or rendering, a typo shouldn't need a restart to recover from
+void VR::ValidateSettings(VRSettings &settings)
+{
+    const auto clampSetting = [&](const char *key, auto &value, auto minValue, auto maxValue)
+    {
+        auto clamped = std::clamp(value, (std::remove_reference_t<decltype(value)>)minValue, (std::remove_reference_t<decltype(value)>)maxValue);
+        if (clamped != value)
+        {
+            std::cout << "'" << key << "' is out of range, clamping '" << value << "' to '" << clamped << "'\n";
+            value = clamped;
+        }
+    };
+
+    clampSetting("TurnSpeed", settings.m_TurnSpeed, 0.0f, 10.0f);
+    clampSetting("SnapTurnAngle", settings.m_SnapTurnAngle, 1.0f, 180.0f);
+    clampSetting("VRScale", settings.m_VRScale, 1.0f, 1000.0f);
+    clampSetting("IPDScale", settings.m_IpdScale, 0.0f, 10.0f);
+    clampSetting("HudDistance", settings.m_HudDistance, 0.1f, 100.0f);
+    clampSetting("HudSize", settings.m_HudSize, 0.1f, 100.0f);
+    clampSetting("HudUpdateRate", settings.m_HudUpdateRate, 0.0f, 1000.0f);
+    clampSetting("AimMode", settings.m_AimMode, 0, 2);
+    clampSetting("AntiAliasing", settings.m_AntiAliasing, 0, 8);
+    clampSetting("RenderWindow", settings.m_RenderWindow, 0, 2);
+    clampSetting("PortallingDetectionDistanceThreshold", settings.m_PortallingDetectionDistanceThreshold, 0.0f, 1000.0f);
+    clampSetting("CameraUprightRecoverySpeed", settings.m_CameraUprightRecoverySpeed, 0.0f, 1.0f);
+    clampSetting("EyeTextureBuffers", settings.m_EyeTextureBuffers, 1, (int)MAX_EYE_TEXTURE_SETS);
+    clampSetting("InputRecording", settings.m_InputRecordingMode, 0, 2);
+    clampSetting("PipelineWarmUpThreads", settings.m_PipelineWarmUpThreads, 0, 32);
+    clampSetting("PipelineWarmUpBudgetMs", settings.m_PipelineWarmUpBudgetMs, 0.0f, 60000.0f);
+    clampSetting("DynamicResolutionMinScale", settings.m_DynamicResolutionMinScale, 0.1f, 2.0f);
+    clampSetting("DynamicResolutionMaxScale", settings.m_DynamicResolutionMaxScale, settings.m_DynamicResolutionMinScale, 2.0f);
+    clampSetting("DynamicResolutionTargetMs", settings.m_DynamicResolutionTargetMs, 0.0f, 100.0f);
+    clampSetting("DynamicResolutionHysteresis", settings.m_DynamicResolutionHysteresis, 0.0f, 1.0f);
+    clampSetting("HmdPredictionMs", settings.m_HmdPredictionMs, -MAX_PREDICTION_SECONDS * 1000.0f, MAX_PREDICTION_SECONDS * 1000.0f);
+    clampSetting("ControllerPredictionMs", settings.m_ControllerPredictionMs, -MAX_PREDICTION_SECONDS * 1000.0f, MAX_PREDICTION_SECONDS * 1000.0f);
+    clampSetting("UsercmdPredictionMs", settings.m_UsercmdPredictionMs, 0.0f, MAX_PREDICTION_SECONDS * 1000.0f);
+}
+
+// Parses config.txt and publishes it if its contents changed since the last time. Returns true if a new snapshot was published.
+bool VR::ReloadConfig()
+{
+    std::ifstream configStream("VR\\config.txt", std::ios::binary);
+    if (!configStream)
+    {
+        concatErrorMsg(*m_Game, "'config.txt' not found.");
+        return false;
+    }
+
+    const std::string config((std::istreambuf_iterator<char>(configStream)), std::istreambuf_iterator<char>());
+
+    // The directory notification fires for every file in VR\, and editors often save in several writes
+    if (!m_ConfigContents.IsNew(config))
+        return false;
+
+    try
+    {
+        std::shared_ptr<const VRSettings> settings = ParseConfigFile(config);
+        if (!settings)
+            return false;
+
+        std::atomic_store(&m_Settings, settings);
+    }
+    catch (const std::logic_error &e)
+    {
+        // Most likely caught the file halfway through being written, the next write will bring us back here
+        concatErrorMsg(*m_Game, "Failed to parse 'config.txt' (", e.what(), ")");
+        return false;
+    }
+
+    m_ConfigContents.Accept(config);
+    std::cout << "Successfully reloaded 'config.txt'\n";
+    return true;
+}
+
+// Called at the start of every frame on the render thread, so settings never change halfway through a frame
+void VR::ApplySettings()
+{
+    std::shared_ptr<const VRSettings> settings = std::atomic_load(&m_Settings);
+    if (!settings || settings == m_AppliedSettings)
+        return;
+
+    static_cast<VRSettings &>(*this) = *settings;
+    m_AppliedSettings = std::move(settings);
 }
 
 void VR::WaitForConfigUpdate()
 {
-    char currentDir[MAX_STR_LEN];
-    GetCurrentDirectory(MAX_STR_LEN, currentDir);
-    char configDir[MAX_STR_LEN];
-    sprintf_s(configDir, MAX_STR_LEN, "%s\\VR\\", currentDir);
-    HANDLE fileChangeHandle = FindFirstChangeNotificationA(configDir, false, FILE_NOTIFY_CHANGE_LAST_WRITE);
+    ConfigWatcher watcher;
+    if (!watcher.Open("VR"))
+    {
+        concatErrorMsg(*m_Game, "Failed to watch 'config.txt' for changes.");
+        return;
+    }
 
-    std::filesystem::file_time_type configLastModified;
     while (1)
     {
-        try 
-        {
-            // Windows only notifies of change within a directory, so extra check here for just config.txt
-            auto configModifiedTime = std::filesystem::last_write_time("VR\\config.txt");
-            if (configModifiedTime != configLastModified)
-            {
-                configLastModified = configModifiedTime;
-                ParseConfigFile();
-                
-                std::cout << "Successfully reloaded 'config.txt'\n";
-            }
-        }
-        catch (const std::invalid_argument &e)
-        {
-            concatErrorMsg(
-                *m_Game, "Failed to parse 'config.txt' (", e.what(), ")");
-        }
-        catch (const std::filesystem::filesystem_error &e)
-        {
-            concatErrorMsg(
-                *m_Game, "'config.txt' not found. (", e.what(), ")");
-            
-            return;
-        }
-        
-        FindNextChangeNotification(fileChangeHandle);
-        WaitForSingleObject(fileChangeHandle, INFINITE);
-        Sleep(100); // Sometimes the thread tries to read config.txt before it's finished writing
+        // Let a burst of writes settle before reading, the content check filters out anything that didn't touch the config
+        if (watcher.WaitForSettledChange(ConfigWatcher::WAIT_INFINITE, CONFIG_SETTLE_MS))
+            ReloadConfig();
     }
 }
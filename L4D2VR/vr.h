@@ -1,7 +1,17 @@
 #pragma once
 #include "openvr.h"
 #include "vector.h"
+#include "inputsource.h"
+#include "vrsettings.h"
+#include "vrusercmd.h"
+#include "rendertargetpool.h"
+#include "hudcompositor.h"
+#include "stereobenchmark.h"
+#include "configwatcher.h"
 #include <chrono>
+#include <condition_variable>
+#include <memory>
+#include <mutex>
 
 #define MAX_STR_LEN 256
 
@@ -9,6 +19,7 @@ class Game;
 class IDirect3DTexture9;
 class IDirect3DSurface9;
 class ITexture;
+class CPortal_Base2D;
 
 
 struct TrackedDevicePoseData 
@@ -20,13 +31,54 @@ struct TrackedDevicePoseData
 	QAngle TrackedDeviceAngVel;
 };
 
-struct SharedTextureHolder 
+// Results of the rays traced for the current frame, so each one hits the engine at most once per frame
+struct FrameTraceCache
 {
-	vr::VRVulkanTextureData_t m_VulkanData;
-	vr::Texture_t m_VRTexture;
+	uint64_t m_EyeFrame = UINT64_MAX;
+	Vector m_EyeCameraPos;
+	QAngle m_EyeInputAngles;
+	Vector m_EyeOrigins[2];
+	QAngle m_EyeAngles[2];
+
+	uint64_t m_AimFrame = UINT64_MAX;
+	Vector m_AimPos;
 };
 
-class VR
+// Engine state the hooks read many times a frame, queried once at the top of VR::Update
+struct VRFrameState
+{
+	int m_WindowWidth = 0;
+	int m_WindowHeight = 0;
+	uint32_t m_RenderWidth = 0;
+	uint32_t m_RenderHeight = 0;
+	bool m_IsInGame = false;
+	bool m_IsCursorVisible = false;
+};
+
+// One set of eye render targets. VR cycles through several of them so the game can render
+// the next frame while the compositor still reads the previous one.
+struct EyeTextureSet
+{
+	ITexture *m_LeftEyeTexture = nullptr;
+	ITexture *m_RightEyeTexture = nullptr;
+	IDirect3DSurface9 *m_D9LeftEyeSurface = nullptr;
+	IDirect3DSurface9 *m_D9RightEyeSurface = nullptr;
+	SharedTextureHolder m_VKLeftEye;
+	SharedTextureHolder m_VKRightEye;
+
+	// Only set when the set was created for depth submission
+	IDirect3DSurface9 *m_D9LeftEyeDepthSurface = nullptr;
+	IDirect3DSurface9 *m_D9RightEyeDepthSurface = nullptr;
+	SharedTextureHolder m_VKLeftEyeDepth;
+	SharedTextureHolder m_VKRightEyeDepth;
+
+	// What the set was last rendered with, the compositor needs it to reproject using the depth
+	vr::HmdMatrix34_t m_RenderPose = {};
+	float m_RenderZNear = 0.0f;
+	float m_RenderZFar = 0.0f;
+};
+
+class VR : public VRSettings
 {
 public:
 	Game *m_Game = nullptr;
@@ -36,7 +88,7 @@ public:
 	vr::IVROverlay *m_Overlay = nullptr;
 
 	vr::VROverlayHandle_t m_MainMenuHandle;
-	//vr::VROverlayHandle_t m_HUDHandle;
+	HudCompositor m_HudCompositor;
 
 	float m_HorizontalOffsetLeft;
 	float m_VerticalOffsetLeft;
@@ -45,13 +97,21 @@ public:
 
 	uint32_t m_RenderWidth;
 	uint32_t m_RenderHeight;
-	uint32_t m_AntiAliasing;
-	uint32_t m_RenderWindow;
 	float m_Aspect;
 	float m_Fov;
 
 	vr::VRTextureBounds_t m_TextureBounds[2];
-	vr::TrackedDevicePose_t m_Poses[vr::k_unMaxTrackedDeviceCount];
+
+	// Dynamic resolution: eye textures are allocated at the max scale, each frame only renders into a m_ViewportWidth x m_ViewportHeight corner of it
+	uint32_t m_EyeTextureWidth;
+	uint32_t m_EyeTextureHeight;
+	uint32_t m_ViewportWidth;
+	uint32_t m_ViewportHeight;
+	float m_ResolutionScale = 1.0f;
+	float m_GpuFrameTimeAvg = 0.0f;
+	int m_ResolutionCooldown = 0;
+	float m_DisplayFrequency = 90.0f;
+	InputSource m_InputSource;
 
 	Vector m_EyeToHeadTransformPosLeft = { 0,0,0 };
 	Vector m_EyeToHeadTransformPosRight = { 0,0,0 };
@@ -85,6 +145,17 @@ public:
 	Vector m_AimPos = { 0, 0, 0 };
 	bool m_Traced = false;
 
+	uint64_t m_FrameNumber = 0; // Incremented by every Update()
+	FrameTraceCache m_TraceCache;
+	VRFrameState m_FrameState;
+
+	int m_AppliedInputRecordingMode = 0;
+
+	StereoBenchmark m_StereoBenchmark;
+	bool m_AppliedRunStereoBenchmark = false;
+
+	VRUsercmdHistory m_SentUsercmds; // Payloads written by Hooks::dWriteUsercmd, by command number. Cleared when entering or leaving a game.
+
 	Vector m_Center = { 0,0,0 };
 	Vector m_SetupOrigin = { 0,0,0 };
 
@@ -93,15 +164,13 @@ public:
 
 	Vector m_LeftControllerPosAbs;											
 	QAngle m_LeftControllerAngAbs;
+	Vector m_LeftControllerPosRel;
 	Vector m_RightControllerPosRel;											
 	QAngle m_RightControllerAngAbs;
 
 	Vector m_ViewmodelPosOffset;
 	QAngle m_ViewmodelAngOffset;
 
-	Vector m_ViewmodelPosCustomOffset; // Custom (from config) viewmodel position offset applied on top of hardcoded ones
-    QAngle m_ViewmodelAngCustomOffset; // Custom (from config) viewmodel angle offset applied on top of hardcoded ones
-
 	float m_Ipd;																	
 	float m_EyeZ;
 
@@ -116,6 +185,13 @@ public:
 		Texture_Blank
 	};
 
+	static constexpr uint32_t MAX_EYE_TEXTURE_SETS = 3;
+
+	// The eye textures below always belong to m_EyeTextureSets[m_EyeTextureSetIndex]
+	EyeTextureSet m_EyeTextureSets[MAX_EYE_TEXTURE_SETS];
+	uint32_t m_EyeTextureSetCount = 1;
+	uint32_t m_EyeTextureSetIndex = 0;
+
 	ITexture *m_LeftEyeTexture;
 	ITexture *m_RightEyeTexture;
 	ITexture *m_HUDTexture;
@@ -126,17 +202,40 @@ public:
 	IDirect3DSurface9 *m_D9HUDSurface;
 	IDirect3DSurface9 *m_D9BlankSurface;
 
+	// Filled in by dxvk when it creates the depth buffer of an eye texture while m_DepthTextureActive is set
+	IDirect3DSurface9 *m_D9LeftEyeDepthSurface = nullptr;
+	IDirect3DSurface9 *m_D9RightEyeDepthSurface = nullptr;
+	SharedTextureHolder m_VKLeftEyeDepth;
+	SharedTextureHolder m_VKRightEyeDepth;
+
 	SharedTextureHolder m_VKLeftEye;
 	SharedTextureHolder m_VKRightEye;
 	SharedTextureHolder m_VKBackBuffer;
 	SharedTextureHolder m_VKHUD;
 	SharedTextureHolder m_VKBlankTexture;
 
+	RenderTargetPool m_RenderTargetPool; // Keeps the render targets above between CreateVRTextures calls
+
+	// Async submission: the render thread queues the eye textures, SubmitThread() hands them to the compositor
+	std::mutex m_SubmitLock;
+	std::condition_variable m_SubmitCondition;
+	bool m_SubmitPending = false;			// Queued or being submitted, guarded by m_SubmitLock
+	bool m_AsyncSubmitFrame = false;		// This frame's eye textures go through the submit thread
+	uint64_t m_SubmitSequenceNumber = 0;
+	vr::VRTextureWithPoseAndDepth_t m_SubmitTextures[2];
+	vr::EVRSubmitFlags m_SubmitFlags[2];
+	vr::VRTextureBounds_t m_SubmitBounds[2];
+	IDirect3DSurface9 *m_SubmitSurfaces[5];		// Color and depth of both eyes, and the HUD if it was repainted
+	bool m_SubmitHud = false;				// The HUD texture is among m_SubmitSurfaces
+	uint32_t m_SubmitSurfaceCount = 0;		// Surfaces still in the compositor's layout, see WaitForAsyncSubmit
+
 	bool m_IsVREnabled = false;
 	bool m_IsInitialized = false;
 	bool m_RenderedNewFrame = false;
 	bool m_RenderedHud = false;
 	bool m_CreatedVRTextures = false;
+	bool m_DepthTextureActive = false; // Eye depth buffers were created so they can be shared with the compositor
+	bool m_HudOverlayActive = false; // The HUD render target was created for the HUD overlay
 	bool m_DrawCrosshair = false;
 	TextureID m_CreatingTextureID = Texture_None;
 
@@ -175,6 +274,7 @@ public:
 	vr::VRActionHandle_t m_ThirdAttack;
 
 	TrackedDevicePoseData m_HmdPose;
+	vr::HmdMatrix34_t m_HmdPoseMatrix = {}; // m_HmdPose as the compositor wants it back with the frame
 	TrackedDevicePoseData m_LeftControllerPose;
 	TrackedDevicePoseData m_RightControllerPose;
 
@@ -185,33 +285,41 @@ public:
 	std::chrono::steady_clock::time_point m_PrevFrameTime;
 	bool m_InitialPosReset = false;
 
-	float m_TurnSpeed = 0.15;
-	bool m_SnapTurning = true;
-	float m_SnapTurnAngle = 45.0;
-	bool m_LeftHanded = false;
-	float m_VRScale = 43.2;
-	float m_IpdScale = 1.0;
-	bool m_6DOF = true;
-	bool m_SeatedMode = false;
-	float m_HudDistance = 1.3;
-	float m_HudSize = 4.0;
-	bool m_HudAlwaysVisible = false;
-	int m_AimMode = 2;
-	float m_PortallingDetectionDistanceThreshold = 35.f; // The distance threshold used to detect portalling
-	bool m_ApplyPitchAndRollPortalRotationOffset = false; // If `true`, the camera pitch/roll follows the exit portal's orientation when portalling
-	float m_CameraUprightRecoverySpeed = 0.2f; // If the above is `true`, this controls how quickly the camera turns back upright after portalling
+	// Newest config published by the config thread, only ever replaced as a whole through std::atomic_store
+	std::shared_ptr<const VRSettings> m_Settings;
+	std::shared_ptr<const VRSettings> m_AppliedSettings; // The snapshot VRSettings was last copied from
+	ConfigContents m_ConfigContents; // The config.txt contents m_Settings was parsed from
+	static constexpr int CONFIG_SETTLE_MS = 50; // How long the config directory has to be quiet before config.txt is read
 
 	VR() {};
 	VR(Game *game);
 	int SetActionManifest(const char *fileName);
 	void InstallApplicationManifest(const char *fileName);
 	void Update();
+	void UpdateFrameState();
+	void WarmUpPipelines();
 	void SetScreenSizeOverride(bool bState);
 	void CreateVRTextures();
+	const PooledRenderTarget &AcquireRenderTarget(const RenderTargetKey &key, TextureID textureID);
+	void SelectEyeTextureSet(uint32_t index);
+	void AcquireNextEyeTextureSet();
 	void SubmitVRTextures();
+	bool BeginAsyncSubmitFrame();
+	void QueueAsyncSubmit(const vr::VRTextureBounds_t &leftBounds, const vr::VRTextureBounds_t &rightBounds, bool submitHud);
+	void WaitForAsyncSubmit();
+	void SubmitThread();
+	bool BeginHudPaint();
+	bool UseSharedEyePasses() const;
+	void EndStereoBenchmarkFrame(uint64_t eyesNanoseconds);
+	void MirrorToWindow();
+	vr::VRTextureBounds_t GetSubmitBounds(vr::EVREye eye);
+	vr::EVRSubmitFlags GetSubmitTexture(vr::EVREye eye, vr::VRTextureWithPoseAndDepth_t &textureOut);
+	void UpdateDynamicResolution();
 	void RepositionOverlays();
 	void GetPoses();
 	void UpdatePosesAndActions();
+	void TrackPoses();
+	bool LatchPoses();
 	void GetViewParameters();
 	void ProcessMenuInput();
 	void ProcessInput();
@@ -221,9 +329,12 @@ public:
 	QAngle GetRightControllerAbsAngle();
 	QAngle& GetRightControllerAbsAngleConst();
 	Vector GetRightControllerAbsPos(Vector eyePosition = {0, 0, 0});
+	void GetUsercmdPayload(VRUsercmdPayload &payload);
+	void PredictRightController(float seconds, Vector &posOut, QAngle &angOut);
 	Vector GetRecommendedViewmodelAbsPos(Vector eyePosition);
 	QAngle GetRecommendedViewmodelAbsAngle();
 	void UpdateHMDAngles();
+	void UpdateHMDTracking();
 	void UpdateTracking();
 	Vector GetViewAngle();
 	Vector GetViewOrigin(Vector setupOrigin);
@@ -233,8 +344,12 @@ public:
 	bool GetAnalogActionData(vr::VRActionHandle_t &actionHandle, vr::InputAnalogActionData_t &analogDataOut);
 	void ResetPosition();
 	void GetPoseData(vr::TrackedDevicePose_t &poseRaw, TrackedDevicePoseData &poseOut);
-	void ParseConfigFile();
+	std::shared_ptr<VRSettings> ParseConfigFile(const std::string &config);
+	void ValidateSettings(VRSettings &settings);
+	bool ReloadConfig();
+	void ApplySettings();
 	void WaitForConfigUpdate();
 	Vector Trace(uint32_t* localPlayer);
-	Vector TraceEye(uint32_t* localPlayer, Vector cameraPos, Vector eyePos, QAngle& eyeAngle);
+	Vector TraceEye(uint32_t* localPlayer, Vector cameraPos, Vector eyePos, QAngle& eyeAngle, CPortal_Base2D **portalHint = nullptr);
+	void ResolveEyeOrigins(uint32_t* localPlayer, const Vector &cameraPos, const QAngle &angles, Vector &leftOrigin, QAngle &leftAngles, Vector &rightOrigin, QAngle &rightAngles);
 };
\ No newline at end of file
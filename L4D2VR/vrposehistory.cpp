@@ -0,0 +1,66 @@
+#include "vrposehistory.h"
+#include <cmath>
+
+void VRPoseHistory::Add(int tick, const Vector &controllerPos, const QAngle &controllerAngle)
+{
+	// Find the first sample that isn't older than 'tick', usually there is none and we append
+	int insertAt = m_Count;
+	while (insertAt > 0 && At(insertAt - 1).m_Tick >= tick)
+		--insertAt;
+
+	if (insertAt < m_Count && At(insertAt).m_Tick == tick)
+	{
+		At(insertAt) = { tick, controllerPos, controllerAngle };
+		return;
+	}
+
+	// A full history drops its oldest sample, unless the new one would be older than everything in it
+	if (m_Count == CAPACITY)
+	{
+		if (insertAt == 0)
+			return;
+
+		m_Start = (m_Start + 1) % CAPACITY;
+		--m_Count;
+		--insertAt;
+	}
+
+	for (int i = m_Count; i > insertAt; --i)
+		At(i) = At(i - 1);
+
+	At(insertAt) = { tick, controllerPos, controllerAngle };
+	++m_Count;
+}
+
+bool VRPoseHistory::Sample(float tick, Vector &controllerPos, QAngle &controllerAngle) const
+{
+	if (m_Count == 0)
+		return false;
+
+	int next = 0;
+	while (next < m_Count && At(next).m_Tick < tick)
+		++next;
+
+	if (next == 0 || next == m_Count)
+	{
+		const VRPoseSample &sample = At(next == 0 ? 0 : m_Count - 1);
+		controllerPos = sample.m_ControllerPos;
+		controllerAngle = sample.m_ControllerAngle;
+		return true;
+	}
+
+	const VRPoseSample &a = At(next - 1);
+	const VRPoseSample &b = At(next);
+	const float t = (tick - a.m_Tick) / (b.m_Tick - a.m_Tick);
+
+	controllerPos = a.m_ControllerPos + (b.m_ControllerPos - a.m_ControllerPos) * t;
+
+	// Take the short way around, yaw wraps from 180 to -180
+	for (int i = 0; i < 3; ++i)
+	{
+		const float delta = remainderf(b.m_ControllerAngle[i] - a.m_ControllerAngle[i], 360.0f);
+		controllerAngle[i] = a.m_ControllerAngle[i] + delta * t;
+	}
+
+	return true;
+}
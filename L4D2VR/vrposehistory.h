@@ -0,0 +1,39 @@
+#pragma once
+#include "vector.h"
+
+struct VRPoseSample
+{
+	int m_Tick;
+	Vector m_ControllerPos;
+	QAngle m_ControllerAngle;
+};
+
+// The last few controller poses a VR player sent, ordered by the tick_count of the usercmd they came with.
+// Lets the server look up where the hand was on the tick a command was issued instead of where it is now,
+// which matters when commands arrive in bursts after packet loss or jitter.
+class VRPoseHistory
+{
+public:
+	// Commands are resent until acked, samples for ticks we already have are overwritten in place
+	void Add(int tick, const Vector &controllerPos, const QAngle &controllerAngle);
+	void Clear() { m_Count = 0; }
+
+	// Interpolates between the samples around 'tick', clamps to the oldest/newest sample outside of the history.
+	// Returns false if there are no samples.
+	bool Sample(float tick, Vector &controllerPos, QAngle &controllerAngle) const;
+
+	bool IsEmpty() const { return m_Count == 0; }
+	int OldestTick() const { return At(0).m_Tick; }
+	int NewestTick() const { return At(m_Count - 1).m_Tick; }
+
+private:
+	// About half a second at 66 ticks, more than any command burst
+	static constexpr int CAPACITY = 32;
+
+	const VRPoseSample &At(int i) const { return m_Samples[(m_Start + i) % CAPACITY]; }
+	VRPoseSample &At(int i) { return m_Samples[(m_Start + i) % CAPACITY]; }
+
+	VRPoseSample m_Samples[CAPACITY];
+	int m_Start = 0;
+	int m_Count = 0;
+};
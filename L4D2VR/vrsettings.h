@@ -0,0 +1,50 @@
+#pragma once
+#include "vector.h"
+#include <cstdint>
+
+// Everything read from VR\config.txt. The config thread parses the file into a fresh VRSettings and publishes it
+// as an immutable snapshot, VR::Update copies the newest one into VR between frames.
+struct VRSettings
+{
+	float m_TurnSpeed = 0.15;
+	bool m_SnapTurning = true;
+	float m_SnapTurnAngle = 45.0;
+	bool m_LeftHanded = false;
+	float m_VRScale = 43.2;
+	float m_IpdScale = 1.0;
+	bool m_6DOF = true;
+	bool m_SeatedMode = false;
+	float m_HudDistance = 1.3;
+	float m_HudSize = 4.0;
+	bool m_HudAlwaysVisible = false;
+	bool m_HudOverlay = false; // Show the VGUI HUD on an overlay, it isn't painted at all otherwise
+	float m_HudUpdateRate = 30.0f; // How often (Hz) the HUD is repainted while its overlay is visible, 0 = every frame
+	int m_AimMode = 2;
+	uint32_t m_AntiAliasing = 0;
+	uint32_t m_RenderWindow = 0;
+	Vector m_ViewmodelPosCustomOffset = { 0,0,0 }; // Custom (from config) viewmodel position offset applied on top of hardcoded ones
+	QAngle m_ViewmodelAngCustomOffset = { 0,0,0 }; // Custom (from config) viewmodel angle offset applied on top of hardcoded ones
+	float m_PortallingDetectionDistanceThreshold = 35.f; // The distance threshold used to detect portalling
+	bool m_ApplyPitchAndRollPortalRotationOffset = false; // If `true`, the camera pitch/roll follows the exit portal's orientation when portalling
+	float m_CameraUprightRecoverySpeed = 0.2f; // If the above is `true`, this controls how quickly the camera turns back upright after portalling
+	bool m_TrackingThread = false; // Keep sampling poses on a separate thread so rendering can pick up fresher ones than WaitGetPoses returned
+	bool m_SharedEyePasses = false; // Only the left eye runs the HUD pass and renders camera monitors, the right eye reuses them
+	bool m_RunStereoBenchmark = false; // Alternate SharedEyePasses off and on for a while and print how long the eyes took with each
+	int m_EyeTextureBuffers = 2; // Number of eye texture sets to cycle through, up to MAX_EYE_TEXTURE_SETS
+	bool m_AsyncSubmit = false; // Submit the eye textures from a separate thread instead of waiting for the GPU to go idle every frame
+	bool m_SubmitDepth = false; // Submit the eye depth buffers and render pose too, so the compositor can reproject with depth
+	bool m_PipelineWarmUp = false; // Compile the cached pipelines of a map before its first frame instead of when a draw first needs them
+	int m_PipelineWarmUpThreads = 2; // Compiler threads added on top of the async ones while warming up
+	float m_PipelineWarmUpBudgetMs = 3000.0f; // Longest the warm-up may hold up the first frame, the rest compiles in the background
+	int m_InputRecordingMode = 0; // 0 = off, 1 = record tracking and input to VR\input.rec, 2 = replay it instead of the headset
+	bool m_FrameTiming = false; // Record render loop stage timings, switching it off dumps them to VR\frametiming.csv/.json
+	bool m_DynamicResolution = false; // Lower the eye render resolution when the GPU can't keep up
+	float m_DynamicResolutionMinScale = 0.6f;
+	float m_DynamicResolutionMaxScale = 1.0f;
+	float m_DynamicResolutionTargetMs = 0.0f; // GPU frame time to aim for, 0 = 90% of the HMD's frame interval
+	float m_DynamicResolutionHysteresis = 0.1f; // How far (relative) the frame time has to be off the target before the scale changes
+	bool m_PosePrediction = false; // Extrapolate poses when the frame is displayed later than the one they were predicted for
+	float m_HmdPredictionMs = 0.0f; // Extra HMD prediction on top of that
+	float m_ControllerPredictionMs = 0.0f; // Extra controller prediction on top of that
+	float m_UsercmdPredictionMs = 20.0f; // How far ahead the controller pose sent to the server is predicted
+};
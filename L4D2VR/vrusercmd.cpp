@@ -0,0 +1,383 @@
+#include "vrusercmd.h"
+#include "bitbuf.h"
+#include "coordsize.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+namespace
+{
+	constexpr int VERSION_BITS = 3;
+	constexpr int LENGTH_BITS = 9;
+	constexpr int MAX_PAYLOAD_BYTES = (1 << LENGTH_BITS) / 8;
+
+	// Quaternion components other than the largest are within +-1/sqrt(2)
+	constexpr int ROT_BITS = 10;
+	constexpr int ROT_MAX = (1 << (ROT_BITS - 1)) - 1;
+	constexpr float ROT_RANGE = 0.70710678f;
+
+	// Positions are in 1/8 units, the resolution of the engine's low precision coordinates
+	constexpr int POS_DENOMINATOR = COORD_DENOMINATOR_LOWPRECISION;
+	constexpr int POS_BITS = 1 + COORD_INTEGER_BITS + COORD_FRACTIONAL_BITS_MP_LOWPRECISION;
+	constexpr int32_t POS_MAX = MAX_COORD_INTEGER * POS_DENOMINATOR - 1;
+
+	// Absolute controller positions within 64 units of the headset are sent relative to it
+	constexpr int POS_NEAR_BITS = 10;
+
+	struct DeltaBits
+	{
+		int m_Small;
+		int m_Large;
+	};
+
+	// Chosen so walking, or a hand moving at a brisk pace, fits the small delta at 90 commands a second. The
+	// controllers are sent relative to the movement of the headset, walking moves all three devices alike.
+	constexpr DeltaBits POS_DELTA_BITS = { 5, 9 };
+	constexpr DeltaBits ROT_DELTA_BITS = { 4, 8 };
+
+	enum DeltaMode
+	{
+		Delta_Unchanged,
+		Delta_Small,
+		Delta_Large,
+		Delta_Absolute
+	};
+
+	bool FitsBits(int32_t value, int bits)
+	{
+		return value >= -(1 << (bits - 1)) && value < (1 << (bits - 1));
+	}
+
+	// Picks the cheapest mode 'to' can be sent in relative to 'from', absolute if there's no baseline
+	DeltaMode ChooseMode(const int32_t to[3], const int32_t *from, const DeltaBits &bits)
+	{
+		if (!from)
+			return Delta_Absolute;
+
+		const int32_t delta[3] = { to[0] - from[0], to[1] - from[1], to[2] - from[2] };
+		if (!delta[0] && !delta[1] && !delta[2])
+			return Delta_Unchanged;
+
+		if (std::all_of(delta, delta + 3, [&bits](int32_t d) { return FitsBits(d, bits.m_Small); }))
+			return Delta_Small;
+
+		if (std::all_of(delta, delta + 3, [&bits](int32_t d) { return FitsBits(d, bits.m_Large); }))
+			return Delta_Large;
+
+		return Delta_Absolute;
+	}
+
+	void WriteDeltas(bf_write *buf, DeltaMode mode, const int32_t to[3], const int32_t from[3], const DeltaBits &bits)
+	{
+		if (mode == Delta_Small || mode == Delta_Large)
+		{
+			for (int i = 0; i < 3; ++i)
+				buf->WriteSBitLong(to[i] - from[i], mode == Delta_Small ? bits.m_Small : bits.m_Large);
+		}
+	}
+
+	void ReadDeltas(bf_read *buf, DeltaMode mode, int32_t to[3], const int32_t *from, const DeltaBits &bits)
+	{
+		for (int i = 0; i < 3; ++i)
+		{
+			const int32_t base = from ? from[i] : 0;
+			if (mode == Delta_Unchanged)
+				to[i] = base;
+			else
+				to[i] = base + buf->ReadSBitLong(mode == Delta_Small ? bits.m_Small : bits.m_Large);
+		}
+	}
+
+	// 'anchor' is the position of the headset the absolute position of a controller can be sent relative to
+	void WriteAbsolutePos(bf_write *buf, const int32_t pos[3], const int32_t *anchor)
+	{
+		if (anchor)
+		{
+			const int32_t offset[3] = { pos[0] - anchor[0], pos[1] - anchor[1], pos[2] - anchor[2] };
+			const bool near = std::all_of(offset, offset + 3, [](int32_t d) { return FitsBits(d, POS_NEAR_BITS); });
+			buf->WriteOneBit(near);
+			if (near)
+			{
+				for (int i = 0; i < 3; ++i)
+					buf->WriteSBitLong(offset[i], POS_NEAR_BITS);
+				return;
+			}
+		}
+
+		for (int i = 0; i < 3; ++i)
+			buf->WriteSBitLong(pos[i], POS_BITS);
+	}
+
+	void ReadAbsolutePos(bf_read *buf, int32_t pos[3], const int32_t *anchor)
+	{
+		if (anchor && buf->ReadOneBit())
+		{
+			for (int i = 0; i < 3; ++i)
+				pos[i] = anchor[i] + buf->ReadSBitLong(POS_NEAR_BITS);
+			return;
+		}
+
+		for (int i = 0; i < 3; ++i)
+			pos[i] = buf->ReadSBitLong(POS_BITS);
+	}
+
+	void WritePose(bf_write *buf, const QuantizedPose &to, const QuantizedPose *from, const int32_t *anchor, bool hasBaseline)
+	{
+		DeltaMode posMode = ChooseMode(to.m_Pos, from ? from->m_Pos : nullptr, POS_DELTA_BITS);
+
+		// The rotation deltas only make sense while the same component is left out
+		const bool rotComparable = from && from->m_RotLargest == to.m_RotLargest;
+		DeltaMode rotMode = ChooseMode(to.m_Rot, rotComparable ? from->m_Rot : nullptr, ROT_DELTA_BITS);
+
+		if (hasBaseline)
+			buf->WriteUBitLong(posMode, 2);
+
+		if (posMode == Delta_Absolute)
+			WriteAbsolutePos(buf, to.m_Pos, anchor);
+		else
+		{
+			WriteDeltas(buf, posMode, to.m_Pos, from->m_Pos, POS_DELTA_BITS);
+		}
+
+		if (hasBaseline)
+			buf->WriteUBitLong(rotMode, 2);
+
+		if (rotMode == Delta_Absolute)
+		{
+			buf->WriteUBitLong(to.m_RotLargest, 2);
+			for (int i = 0; i < 3; ++i)
+				buf->WriteSBitLong(to.m_Rot[i], ROT_BITS);
+		}
+		else
+		{
+			WriteDeltas(buf, rotMode, to.m_Rot, from->m_Rot, ROT_DELTA_BITS);
+		}
+	}
+
+	// 'from' may be null even though the sender used a baseline, the bits are still consumed then and false is returned
+	bool ReadPose(bf_read *buf, QuantizedPose &to, const QuantizedPose *from, const int32_t *anchor, bool hasBaseline)
+	{
+		bool valid = true;
+
+		DeltaMode posMode = hasBaseline ? (DeltaMode)buf->ReadUBitLong(2) : Delta_Absolute;
+		if (posMode == Delta_Absolute)
+			ReadAbsolutePos(buf, to.m_Pos, anchor);
+		else
+		{
+			valid &= from != nullptr;
+			ReadDeltas(buf, posMode, to.m_Pos, from ? from->m_Pos : nullptr, POS_DELTA_BITS);
+		}
+
+		DeltaMode rotMode = hasBaseline ? (DeltaMode)buf->ReadUBitLong(2) : Delta_Absolute;
+		if (rotMode == Delta_Absolute)
+		{
+			to.m_RotLargest = buf->ReadUBitLong(2);
+			for (int i = 0; i < 3; ++i)
+				to.m_Rot[i] = buf->ReadSBitLong(ROT_BITS);
+		}
+		else
+		{
+			valid &= from != nullptr;
+			to.m_RotLargest = from ? from->m_RotLargest : 0;
+			ReadDeltas(buf, rotMode, to.m_Rot, from ? from->m_Rot : nullptr, ROT_DELTA_BITS);
+		}
+
+		return valid;
+	}
+
+	// The baseline a device is delta encoded against. Controllers are moved along with the headset first, so
+	// walking or a headset bobbing along doesn't show up in their deltas. Null if there's nothing to delta against.
+	const QuantizedPose *DeviceBaseline(int device, const VRUsercmdPayload &to, const VRUsercmdPayload *from,
+		QuantizedPose &moved)
+	{
+		if (!from || !from->HasPose((VRUsercmdDevice)device))
+			return nullptr;
+
+		const QuantizedPose &base = from->m_Poses[device];
+		if (device == VRDevice_Hmd || !to.HasPose(VRDevice_Hmd) || !from->HasPose(VRDevice_Hmd))
+			return &base;
+
+		moved = base;
+		for (int i = 0; i < 3; ++i)
+			moved.m_Pos[i] += to.m_Poses[VRDevice_Hmd].m_Pos[i] - from->m_Poses[VRDevice_Hmd].m_Pos[i];
+		return &moved;
+	}
+
+	const int32_t *DeviceAnchor(int device, const VRUsercmdPayload &to)
+	{
+		return device != VRDevice_Hmd && to.HasPose(VRDevice_Hmd) ? to.m_Poses[VRDevice_Hmd].m_Pos : nullptr;
+	}
+
+	// Same conventions as the engine's AngleQuaternion, components in x, y, z, w order
+	void AnglesToQuaternion(const QAngle &angles, float q[4])
+	{
+		float sp, cp, sy, cy, sr, cr;
+		SinCos(DEG2RAD(angles.x) * 0.5f, &sp, &cp);
+		SinCos(DEG2RAD(angles.y) * 0.5f, &sy, &cy);
+		SinCos(DEG2RAD(angles.z) * 0.5f, &sr, &cr);
+
+		q[0] = sr * cp * cy - cr * sp * sy;
+		q[1] = cr * sp * cy + sr * cp * sy;
+		q[2] = cr * cp * sy - sr * sp * cy;
+		q[3] = cr * cp * cy + sr * sp * sy;
+	}
+
+	void QuaternionToAngles(const float q[4], QAngle &angles)
+	{
+		const float x = q[0], y = q[1], z = q[2], w = q[3];
+
+		const Vector forward = { 1.0f - 2.0f * (y * y + z * z), 2.0f * (x * y + w * z), 2.0f * (x * z - w * y) };
+		const Vector up = { 2.0f * (x * z + w * y), 2.0f * (y * z - w * x), 1.0f - 2.0f * (x * x + y * y) };
+
+		QAngle::VectorAngles(forward, up, angles);
+	}
+}
+
+void VRUsercmdPayload::SetPose(VRUsercmdDevice device, const Vector &pos, const QAngle &angles)
+{
+	QuantizedPose &pose = m_Poses[device];
+
+	for (int i = 0; i < 3; ++i)
+		pose.m_Pos[i] = std::clamp((int32_t)lroundf(pos[i] * POS_DENOMINATOR), -POS_MAX, POS_MAX);
+
+	float q[4];
+	AnglesToQuaternion(angles, q);
+
+	uint32_t largest = 0;
+	for (uint32_t i = 1; i < 4; ++i)
+	{
+		if (fabsf(q[i]) > fabsf(q[largest]))
+			largest = i;
+	}
+
+	// q and -q are the same rotation, make the left out component positive so it can be restored from the others
+	const float sign = q[largest] < 0 ? -1.0f : 1.0f;
+
+	pose.m_RotLargest = largest;
+	for (uint32_t i = 0, j = 0; i < 4; ++i)
+	{
+		if (i != largest)
+			pose.m_Rot[j++] = std::clamp((int32_t)lroundf(sign * q[i] / ROT_RANGE * ROT_MAX), -ROT_MAX, ROT_MAX);
+	}
+
+	m_DeviceMask |= 1 << device;
+}
+
+bool VRUsercmdPayload::GetPose(VRUsercmdDevice device, Vector &pos, QAngle &angles) const
+{
+	if (!HasPose(device))
+		return false;
+
+	const QuantizedPose &pose = m_Poses[device];
+
+	for (int i = 0; i < 3; ++i)
+		pos[i] = pose.m_Pos[i] / (float)POS_DENOMINATOR;
+
+	float q[4] = {};
+	float sumSquares = 0.0f;
+	for (uint32_t i = 0, j = 0; i < 4; ++i)
+	{
+		if (i == pose.m_RotLargest)
+			continue;
+
+		q[i] = pose.m_Rot[j++] * ROT_RANGE / ROT_MAX;
+		sumSquares += q[i] * q[i];
+	}
+	q[pose.m_RotLargest] = sqrtf(std::max(0.0f, 1.0f - sumSquares));
+
+	QuaternionToAngles(q, angles);
+	return true;
+}
+
+void VRUsercmdHistory::Store(int commandNumber, const VRUsercmdPayload &payload)
+{
+	const int slot = (unsigned)commandNumber % HISTORY_SIZE;
+	m_CommandNumbers[slot] = commandNumber;
+	m_Payloads[slot] = payload;
+}
+
+const VRUsercmdPayload *VRUsercmdHistory::Find(int commandNumber) const
+{
+	// Command number 0 is the engine's null command, nothing was ever sent for it
+	if (commandNumber == 0)
+		return nullptr;
+
+	const int slot = (unsigned)commandNumber % HISTORY_SIZE;
+	return m_CommandNumbers[slot] == commandNumber ? &m_Payloads[slot] : nullptr;
+}
+
+void VRUsercmdHistory::Clear()
+{
+	for (int &commandNumber : m_CommandNumbers)
+		commandNumber = 0;
+}
+
+int VRUsercmd::BaselineCommand(int commandNumber, int previousCommandNumber)
+{
+	if (commandNumber % KEYFRAME_INTERVAL == 0)
+		return 0;
+
+	if (previousCommandNumber != 0)
+		return previousCommandNumber;
+
+	return commandNumber - commandNumber % KEYFRAME_INTERVAL;
+}
+
+void VRUsercmd::Write(bf_write *buf, const VRUsercmdPayload &to, const VRUsercmdPayload *from)
+{
+	// Written to a scratch buffer first so the length can go in front of it
+	unsigned char data[MAX_PAYLOAD_BYTES];
+	bf_write payload(data, sizeof(data));
+
+	const bool hasBaseline = from != nullptr;
+
+	payload.WriteUBitLong(to.m_DeviceMask, VRDevice_Count);
+	payload.WriteOneBit(hasBaseline);
+
+	for (int device = 0; device < VRDevice_Count; ++device)
+	{
+		if (!to.HasPose((VRUsercmdDevice)device))
+			continue;
+
+		QuantizedPose moved;
+		WritePose(&payload, to.m_Poses[device], DeviceBaseline(device, to, from, moved), DeviceAnchor(device, to), hasBaseline);
+	}
+
+	buf->WriteChar(MARKER);
+	buf->WriteUBitLong(VERSION, VERSION_BITS);
+	buf->WriteUBitLong(payload.GetNumBitsWritten(), LENGTH_BITS);
+	buf->WriteBits(data, payload.GetNumBitsWritten());
+}
+
+bool VRUsercmd::Read(bf_read *buf, VRUsercmdPayload &to, const VRUsercmdPayload *from)
+{
+	const uint32_t version = buf->ReadUBitLong(VERSION_BITS);
+	const int length = buf->ReadUBitLong(LENGTH_BITS);
+	const int end = buf->Tell() + length;
+
+	if (version != VERSION)
+	{
+		buf->Seek(end);
+		return false;
+	}
+
+	to.m_DeviceMask = buf->ReadUBitLong(VRDevice_Count);
+	const bool hasBaseline = buf->ReadOneBit();
+
+	bool valid = !hasBaseline || from != nullptr;
+	for (int device = 0; device < VRDevice_Count; ++device)
+	{
+		if (!to.HasPose((VRUsercmdDevice)device))
+			continue;
+
+		// The headset comes first, its decoded pose is already in 'to' when the controllers need it
+		QuantizedPose moved;
+		valid &= ReadPose(buf, to.m_Poses[device], DeviceBaseline(device, to, from, moved), DeviceAnchor(device, to), hasBaseline);
+	}
+
+	// Whatever we got wrong, the next command still starts where the sender said
+	valid &= buf->Tell() == end;
+	buf->Seek(end);
+
+	return valid && !buf->IsOverflowed();
+}
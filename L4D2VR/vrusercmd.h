@@ -0,0 +1,80 @@
+#pragma once
+#include "vector.h"
+#include <cstdint>
+
+class bf_write;
+class bf_read;
+
+enum VRUsercmdDevice
+{
+	VRDevice_Hmd,
+	VRDevice_LeftController,
+	VRDevice_RightController,
+	VRDevice_Count
+};
+
+// A device pose the way it goes over the wire. Positions are in 1/8 units, the resolution of the
+// engine's low precision coordinates, rotations are smallest-three quaternions. Both ends delta against these exact
+// integers, so the decoded baseline never drifts from the one the sender used.
+struct QuantizedPose
+{
+	int32_t m_Pos[3];
+	int32_t m_Rot[3];			// The three smallest quaternion components
+	uint32_t m_RotLargest;		// Index of the component that was left out
+};
+
+// The VR data appended to every usercmd
+struct VRUsercmdPayload
+{
+	uint32_t m_DeviceMask = 0;	// Bit per VRUsercmdDevice that has a pose
+	QuantizedPose m_Poses[VRDevice_Count] = {};
+
+	void SetPose(VRUsercmdDevice device, const Vector &pos, const QAngle &angles);
+	bool GetPose(VRUsercmdDevice device, Vector &pos, QAngle &angles) const;
+	bool HasPose(VRUsercmdDevice device) const { return m_DeviceMask & (1 << device); }
+};
+
+// Recently sent or received payloads by command number, the baselines for delta encoding
+class VRUsercmdHistory
+{
+public:
+	void Store(int commandNumber, const VRUsercmdPayload &payload);
+	const VRUsercmdPayload *Find(int commandNumber) const;
+	void Clear();
+
+private:
+	// Covers every command the client may still be resending
+	static constexpr int HISTORY_SIZE = 64;
+
+	int m_CommandNumbers[HISTORY_SIZE] = {};
+	VRUsercmdPayload m_Payloads[HISTORY_SIZE];
+};
+
+// Wire format, after the regular usercmd:
+//   char marker, 3 bit version, 9 bit payload length in bits, payload
+// The length lets older readers skip payloads of a newer version. Version 2 payload:
+//   3 bit device mask, 1 bit 'delta against the BaselineCommand'
+//   per device in the mask, headset first: position, then rotation, each either absolute or
+//   (with a baseline) a 2 bit mode: unchanged / small delta / large delta / absolute.
+//   Controller positions are delta encoded after moving the baseline along with the headset,
+//   absolute ones near the headset are sent relative to it.
+namespace VRUsercmd
+{
+	constexpr int MARKER = -3;
+	constexpr int LEGACY_MARKER = -2;	// Unversioned right controller position and angles
+	constexpr uint32_t VERSION = 2;
+
+	// Every KEYFRAME_INTERVAL'th command is sent without a baseline
+	constexpr int KEYFRAME_INTERVAL = 16;
+
+	// The command a payload is delta encoded against, 0 for none. 'previousCommandNumber' is the command before it in
+	// the packet, 0 for the first one. The first one can't count on the server having any command before it, it's
+	// encoded against the last keyframe instead, so a lost packet only stops decoding until the next keyframe.
+	int BaselineCommand(int commandNumber, int previousCommandNumber);
+
+	// 'from' is the payload of the BaselineCommand, nullptr if there's none
+	void Write(bf_write *buf, const VRUsercmdPayload &to, const VRUsercmdPayload *from);
+
+	// Call after reading a MARKER. Returns false if the payload couldn't be decoded, it's skipped either way.
+	bool Read(bf_read *buf, VRUsercmdPayload &to, const VRUsercmdPayload *from);
+}
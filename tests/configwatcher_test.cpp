@@ -0,0 +1,209 @@
+// ConfigWatcher on a scratch directory: plain writes, saving by renaming over the file, timeouts, the settle delay
+// that turns a burst of writes into one reload, and ConfigContents skipping rewrites that change nothing.
+#include "configwatcher.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <thread>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace
+{
+	typedef std::chrono::steady_clock Clock;
+
+	constexpr int SETTLE_MS = 50;	// VR::CONFIG_SETTLE_MS
+
+	int g_Failures = 0;
+
+	void Expect(bool condition, const char *what)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", what);
+			++g_Failures;
+		}
+	}
+
+	int MillisecondsSince(Clock::time_point start)
+	{
+		return (int)std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+	}
+
+	void WriteFile(const std::string &path, const std::string &contents)
+	{
+		FILE *file = fopen(path.c_str(), "wb");
+		if (!file)
+			return;
+
+		fwrite(contents.data(), 1, contents.size(), file);
+		fclose(file);
+	}
+
+	std::string ReadFile(const std::string &path)
+	{
+		std::string contents;
+		FILE *file = fopen(path.c_str(), "rb");
+		if (!file)
+			return contents;
+
+		char buffer[256];
+		size_t read;
+		while ((read = fread(buffer, 1, sizeof(buffer), file)) > 0)
+			contents.append(buffer, read);
+		fclose(file);
+		return contents;
+	}
+
+	// Swallows whatever setting up the test produced
+	void Drain(ConfigWatcher &watcher)
+	{
+		while (watcher.WaitForChange(20))
+			;
+	}
+
+	void TestWatcher(const std::string &root)
+	{
+		const std::string directory = root + "/VR";
+		const std::string config = directory + "/config.txt";
+		mkdir(directory.c_str(), 0700);
+		mkdir((root + "/tmp").c_str(), 0700);
+		WriteFile(config, "VRScale=43.2\n");
+
+		ConfigWatcher watcher;
+		Expect(!watcher.WaitForChange(0), "closed watcher never reports a change");
+		Expect(!watcher.Open((root + "/missing").c_str()), "missing directory can't be watched");
+		Expect(watcher.Open(directory.c_str()), "open");
+
+		// Nothing happens
+		Clock::time_point start = Clock::now();
+		Expect(!watcher.WaitForChange(100), "times out without changes");
+		Expect(MillisecondsSince(start) >= 90, "waits for the timeout");
+
+		// A write from another thread wakes the waiting one
+		std::thread writer([&]()
+		{
+			std::this_thread::sleep_for(std::chrono::milliseconds(50));
+			WriteFile(config, "VRScale=40.0\n");
+		});
+		start = Clock::now();
+		Expect(watcher.WaitForChange(5000), "write wakes the watcher");
+		Expect(MillisecondsSince(start) < 1000, "woken by the write, not the timeout");
+		writer.join();
+		Drain(watcher);
+
+		// Saving by writing a temp file elsewhere and renaming it over the config only produces IN_MOVED_TO
+		const std::string temp = root + "/tmp/config.txt.new";
+		WriteFile(temp, "VRScale=30.0\n");
+		Drain(watcher);
+		Expect(rename(temp.c_str(), config.c_str()) == 0, "rename over the config");
+		Expect(watcher.WaitForChange(1000), "rename over the config is a change");
+		Expect(ReadFile(config) == "VRScale=30.0\n", "renamed contents are in place");
+		Drain(watcher);
+
+		// A burst of writes 20 ms apart settles once, 50 ms after the last one
+		Clock::time_point lastWrite;
+		std::thread burst([&]()
+		{
+			for (int i = 0; i < 6; ++i)
+			{
+				WriteFile(config, "VRScale=" + std::to_string(20 + i) + "\n");
+				lastWrite = Clock::now();
+				std::this_thread::sleep_for(std::chrono::milliseconds(20));
+			}
+		});
+		Expect(watcher.WaitForSettledChange(5000, SETTLE_MS), "burst is reported");
+		const Clock::time_point settled = Clock::now();
+		burst.join();
+		Expect(settled - lastWrite >= std::chrono::milliseconds(SETTLE_MS - 5), "reported only after the burst was quiet for the settle time");
+		Expect(!watcher.WaitForSettledChange(100, SETTLE_MS), "a burst is reported once");
+		Expect(ReadFile(config) == "VRScale=25\n", "settled on the last write");
+
+		Expect(!watcher.WaitForSettledChange(100, SETTLE_MS), "settled wait times out without changes");
+
+		watcher.Close();
+		WriteFile(config, "VRScale=1.0\n");
+		Expect(!watcher.WaitForChange(100), "closed watcher doesn't report changes");
+
+		remove(config.c_str());
+		rmdir(directory.c_str());
+		rmdir((root + "/tmp").c_str());
+	}
+
+	// Reloads the way VR::WaitForConfigUpdate and VR::ReloadConfig do, counting the ones that would parse the file
+	void TestReload(const std::string &root)
+	{
+		const std::string directory = root + "/VR";
+		const std::string config = directory + "/config.txt";
+		const std::string other = directory + "/input.rec";
+		mkdir(directory.c_str(), 0700);
+		WriteFile(config, "VRScale=43.2\n");
+
+		ConfigWatcher watcher;
+		Expect(watcher.Open(directory.c_str()), "open");
+
+		ConfigContents contents;
+		const auto reload = [&]()
+		{
+			if (!watcher.WaitForSettledChange(1000, SETTLE_MS))
+				return -1;
+
+			const std::string text = ReadFile(config);
+			if (!contents.IsNew(text))
+				return 0;
+
+			contents.Accept(text);
+			return 1;
+		};
+
+		Expect(contents.IsNew(ReadFile(config)), "nothing accepted yet, everything is new");
+		contents.Accept(ReadFile(config));
+
+		WriteFile(config, "VRScale=43.2\n");
+		Expect(reload() == 0, "rewriting the same contents doesn't reload");
+
+		WriteFile(other, "not the config");
+		Expect(reload() == 0, "another file in the directory doesn't reload");
+
+		WriteFile(config, "VRScale=50.0\n");
+		Expect(reload() == 1, "changed contents reload");
+
+		WriteFile(config, "VRScale=50.0\n");
+		Expect(reload() == 0, "rewriting the reloaded contents doesn't reload again");
+
+		// An editor truncating first and writing the contents back is one settled change with the same contents
+		WriteFile(config, "");
+		WriteFile(config, "VRScale=50.0\n");
+		Expect(reload() == 0, "truncate and rewrite of the same contents doesn't reload");
+
+		Expect(reload() == -1, "nothing left to reload");
+
+		remove(config.c_str());
+		remove(other.c_str());
+		rmdir(directory.c_str());
+	}
+}
+
+int main()
+{
+	char root[] = "/tmp/configwatcher_testXXXXXX";
+	if (!mkdtemp(root))
+	{
+		printf("FAILED: couldn't create a scratch directory\n");
+		return 1;
+	}
+
+	TestWatcher(root);
+	TestReload(root);
+	rmdir(root);
+
+	if (g_Failures)
+	{
+		printf("%d check(s) failed\n", g_Failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
@@ -0,0 +1,218 @@
+// Runs InputSource against the mock OpenVR interfaces: records a session with a tracking thread latching poses
+// in the middle of every frame, then replays it while the mock runtime reports something else entirely. Everything
+// the tracking and input code reads has to come out of the replay exactly as it was recorded.
+#include "inputsource.h"
+#include "mockvr.h"
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr int NUM_FRAMES = 120;
+	constexpr const char *RECORDING_FILE = "inputsource_test.rec";
+
+	constexpr vr::VRActionHandle_t ACTION_JUMP = 1;
+	constexpr vr::VRActionHandle_t ACTION_WALK = 2;
+	constexpr vr::VRActionHandle_t ACTION_UNBOUND = 3;
+
+	int g_Failures = 0;
+
+	void Expect(bool condition, const char *what)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", what);
+			++g_Failures;
+		}
+	}
+
+	// What VR reads from its InputSource during one frame
+	struct FrameReads
+	{
+		vr::TrackedDevicePose_t m_Hmd;
+		vr::TrackedDevicePose_t m_LeftController;
+		vr::TrackedDeviceIndex_t m_LeftIndex;
+		vr::TrackedDeviceIndex_t m_RightIndex;
+		float m_PoseAge;
+		bool m_Latched;
+		vr::TrackedDevicePose_t m_LatchedHmd;
+		float m_LatchedPoseAge;
+		bool m_Jump, m_JumpChanged;
+		bool m_Unbound, m_UnboundChanged;
+		bool m_WalkValid;
+		vr::InputAnalogActionData_t m_Walk;
+		float m_FrameDelta;
+	};
+
+	bool SamePose(const vr::TrackedDevicePose_t &a, const vr::TrackedDevicePose_t &b)
+	{
+		return memcmp(&a, &b, sizeof(a)) == 0;
+	}
+
+	// Same order of calls as VR::Update, ProcessInput and the late latch in dRenderView
+	FrameReads ReadFrame(InputSource &source, int frame, const std::function<void()> &beforeLatch)
+	{
+		FrameReads reads = {};
+		reads.m_Hmd = source.Pose(vr::k_unTrackedDeviceIndex_Hmd);
+		source.GetControllerIndices(reads.m_LeftIndex, reads.m_RightIndex);
+		reads.m_LeftController = source.Pose(reads.m_LeftIndex);
+		reads.m_PoseAge = source.GetPoseAge();
+
+		reads.m_FrameDelta = source.GetFrameDelta(0.011f + frame * 0.0001f);
+		source.GetDigitalAction(ACTION_JUMP, reads.m_Jump, reads.m_JumpChanged);
+		source.GetDigitalAction(ACTION_UNBOUND, reads.m_Unbound, reads.m_UnboundChanged);
+		reads.m_WalkValid = source.GetAnalogAction(ACTION_WALK, reads.m_Walk);
+
+		beforeLatch();
+		reads.m_Latched = source.LatchPoses();
+		if (reads.m_Latched)
+		{
+			reads.m_LatchedHmd = source.Pose(vr::k_unTrackedDeviceIndex_Hmd);
+			reads.m_LatchedPoseAge = source.GetPoseAge();
+		}
+		return reads;
+	}
+
+	// Tracking thread in the background, the devices move unpredictably after every WaitGetPoses
+	std::vector<FrameReads> Record(MockVRState &state, InputSource &source)
+	{
+		std::vector<FrameReads> frames;
+		vr::VRActiveActionSet_t actionSet = {};
+
+		std::atomic<bool> tracking = true;
+		std::thread tracker([&]()
+		{
+			while (tracking)
+			{
+				source.SamplePoses();
+				std::this_thread::sleep_for(std::chrono::microseconds(200));
+			}
+		});
+
+		for (int frame = 0; frame < NUM_FRAMES; ++frame)
+		{
+			state.m_DigitalActions[ACTION_JUMP] = { true, frame % 10 < 5, frame % 5 == 0, vr::k_ulInvalidInputValueHandle, 0.0f };
+			vr::InputAnalogActionData_t &walk = state.m_AnalogActions[ACTION_WALK];
+			walk.bActive = true;
+			walk.x = frame * 0.01f;
+			walk.y = -frame * 0.02f;
+
+			source.BeginFrame(actionSet);
+			state.m_PoseOffset = frame * 0.001f;
+
+			frames.push_back(ReadFrame(source, frame, [&]()
+			{
+				// Rendering takes a while, the tracking thread keeps sampling meanwhile
+				state.m_TimeInFrame = 0.004f;
+				std::this_thread::sleep_for(std::chrono::milliseconds(2));
+			}));
+		}
+
+		tracking = false;
+		tracker.join();
+		return frames;
+	}
+
+	void TestRecordAndReplay()
+	{
+		MockVRState state;
+		MockVRSystem system(state);
+		MockVRCompositor compositor(state);
+		MockVRInput input(state);
+
+		InputSource recorder;
+		recorder.Init(&system, &compositor, &input);
+		Expect(recorder.Recording().SetMode(InputRecording::Mode_Record, RECORDING_FILE), "Recording opens");
+		const std::vector<FrameReads> recorded = Record(state, recorder);
+		recorder.Recording().SetMode(InputRecording::Mode_Off, nullptr);
+
+		int latched = 0;
+		for (const FrameReads &frame : recorded)
+			latched += frame.m_Latched && !SamePose(frame.m_LatchedHmd, frame.m_Hmd);
+		printf("Recorded %d frames, %d latched newer poses\n", NUM_FRAMES, latched);
+		Expect(latched > NUM_FRAMES / 2, "The late latch picks up the tracking thread's poses");
+
+		// A runtime that would give different answers to everything, and no tracking thread
+		state.m_PoseOffset = 100.0f;
+		state.m_LeftController = 5;
+		state.m_DigitalActions.clear();
+		state.m_AnalogActions.clear();
+		const uint64_t runtimeFrame = state.m_Frame;
+		const uint32_t actionStateUpdates = state.m_ActionStateUpdates;
+
+		InputSource player;
+		player.Init(&system, &compositor, &input);
+		Expect(player.Recording().SetMode(InputRecording::Mode_Replay, RECORDING_FILE), "Recording opens for replay");
+
+		vr::VRActiveActionSet_t actionSet = {};
+		bool identical = true;
+		for (int frame = 0; frame < NUM_FRAMES; ++frame)
+		{
+			player.BeginFrame(actionSet);
+			const FrameReads replayed = ReadFrame(player, frame, []() {});
+			const FrameReads &original = recorded[frame];
+
+			bool same = SamePose(replayed.m_Hmd, original.m_Hmd) && SamePose(replayed.m_LeftController, original.m_LeftController)
+				&& replayed.m_LeftIndex == original.m_LeftIndex && replayed.m_RightIndex == original.m_RightIndex
+				&& replayed.m_PoseAge == original.m_PoseAge && replayed.m_Latched == original.m_Latched
+				&& replayed.m_Jump == original.m_Jump && replayed.m_JumpChanged == original.m_JumpChanged
+				&& replayed.m_Unbound == original.m_Unbound && replayed.m_UnboundChanged == original.m_UnboundChanged
+				&& replayed.m_WalkValid == original.m_WalkValid && replayed.m_Walk.x == original.m_Walk.x && replayed.m_Walk.y == original.m_Walk.y
+				&& replayed.m_FrameDelta == original.m_FrameDelta;
+
+			if (original.m_Latched)
+				same = same && SamePose(replayed.m_LatchedHmd, original.m_LatchedHmd) && replayed.m_LatchedPoseAge == original.m_LatchedPoseAge;
+
+			if (!same && identical)
+				printf("First difference in frame %d\n", frame);
+			identical &= same;
+		}
+		Expect(identical, "Replay reads exactly what was recorded, including the latched poses");
+		Expect(state.m_Frame == runtimeFrame && state.m_ActionStateUpdates == actionStateUpdates, "Replay doesn't touch the runtime");
+
+		player.BeginFrame(actionSet);
+		Expect(!player.Recording().IsReplaying(), "Replay switches off after the last frame");
+
+		remove(RECORDING_FILE);
+	}
+
+	void TestLatchOnlyNewerPoses()
+	{
+		MockVRState state;
+		MockVRSystem system(state);
+		MockVRCompositor compositor(state);
+		MockVRInput input(state);
+
+		InputSource source;
+		source.Init(&system, &compositor, &input);
+		vr::VRActiveActionSet_t actionSet = {};
+
+		source.SamplePoses();
+		source.BeginFrame(actionSet);
+		Expect(!source.LatchPoses(), "Poses sampled before WaitGetPoses aren't latched");
+
+		state.m_TimeInFrame = 0.005f;
+		state.m_PoseOffset = 0.5f;
+		source.SamplePoses();
+		Expect(source.LatchPoses(), "Poses sampled after WaitGetPoses are latched");
+		Expect(source.Pose(vr::k_unTrackedDeviceIndex_Hmd).mDeviceToAbsoluteTracking.m[0][3] >= 0.5f, "Latched poses replace the frame's");
+		Expect(!source.LatchPoses(), "The same sample isn't latched twice");
+
+		// Sampled for the same photons WaitGetPoses predicted for, so nothing to extrapolate
+		Expect(source.GetPoseAge() < 0.005f, "Latched poses are as old as the frame being rendered");
+	}
+}
+
+int main()
+{
+	TestLatchOnlyNewerPoses();
+	TestRecordAndReplay();
+
+	if (g_Failures == 0)
+		printf("All input source tests passed\n");
+	return g_Failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,270 @@
+#pragma once
+#include "openvr.h"
+#include <atomic>
+#include <cmath>
+#include <map>
+
+// Stand-ins for the OpenVR runtime, so code that only reaches OpenVR through IVRSystem, IVRCompositor and IVRInput
+// pointers runs without SteamVR or a headset. Everything they report comes from a MockVRState the test scripts,
+// the calls it doesn't script return zeroes.
+
+// Devices 0 (HMD) to 2 (controllers) are connected. Every device moves along X at its own speed and turns around Y,
+// so a pose tells exactly which point in time it was predicted for.
+struct MockVRState
+{
+	static constexpr uint32_t NUM_DEVICES = 3;
+
+	float m_FrameDuration = 1.0f / 90.0f;
+	float m_VsyncToPhotons = 0.01f;
+	std::atomic<float> m_PoseOffset = 0.0f;		// Added to every position, e.g. to move the devices in between predictions
+	vr::TrackedDeviceIndex_t m_LeftController = 1;
+	vr::TrackedDeviceIndex_t m_RightController = 2;
+
+	std::atomic<uint64_t> m_Frame = 0;			// Advanced by every WaitGetPoses
+	std::atomic<float> m_TimeInFrame = 0.0f;	// Seconds since that WaitGetPoses returned, the test moves it along
+	uint32_t m_ActionStateUpdates = 0;
+
+	// Actions that aren't in here report an invalid handle
+	std::map<vr::VRActionHandle_t, vr::InputDigitalActionData_t> m_DigitalActions;
+	std::map<vr::VRActionHandle_t, vr::InputAnalogActionData_t> m_AnalogActions;
+
+	float Now() const { return m_Frame * m_FrameDuration + m_TimeInFrame; }
+
+	void FillPoses(float time, vr::TrackedDevicePose_t *poses, uint32_t count) const
+	{
+		for (uint32_t i = 0; i < count; ++i)
+		{
+			poses[i] = {};
+			if (i >= NUM_DEVICES)
+				continue;
+
+			const float speed = 0.1f * (i + 1);
+			const float yaw = speed * 10.0f * time;
+
+			vr::HmdMatrix34_t &m = poses[i].mDeviceToAbsoluteTracking;
+			m.m[0][0] = cosf(yaw);	m.m[0][2] = sinf(yaw);	m.m[0][3] = speed * time + m_PoseOffset;
+			m.m[1][1] = 1.0f;								m.m[1][3] = 1.0f;
+			m.m[2][0] = -sinf(yaw);	m.m[2][2] = cosf(yaw);
+
+			poses[i].vVelocity.v[0] = speed;
+			poses[i].vAngularVelocity.v[1] = speed * 10.0f;
+			poses[i].eTrackingResult = vr::TrackingResult_Running_OK;
+			poses[i].bPoseIsValid = true;
+			poses[i].bDeviceIsConnected = true;
+		}
+	}
+};
+
+class MockVRSystem : public vr::IVRSystem
+{
+public:
+	explicit MockVRSystem(MockVRState &state) : m_State(state) {}
+
+	void GetDeviceToAbsoluteTrackingPose(vr::ETrackingUniverseOrigin, float secondsToPhotons, vr::TrackedDevicePose_t *poses, uint32_t count) override
+	{
+		m_State.FillPoses(m_State.Now() + secondsToPhotons, poses, count);
+	}
+
+	vr::TrackedDeviceIndex_t GetTrackedDeviceIndexForControllerRole(vr::ETrackedControllerRole role) override
+	{
+		if (role == vr::TrackedControllerRole_LeftHand)
+			return m_State.m_LeftController;
+		if (role == vr::TrackedControllerRole_RightHand)
+			return m_State.m_RightController;
+		return vr::k_unTrackedDeviceIndexInvalid;
+	}
+
+	float GetFloatTrackedDeviceProperty(vr::TrackedDeviceIndex_t, vr::ETrackedDeviceProperty prop, vr::ETrackedPropertyError *) override
+	{
+		if (prop == vr::Prop_DisplayFrequency_Float)
+			return 1.0f / m_State.m_FrameDuration;
+		if (prop == vr::Prop_SecondsFromVsyncToPhotons_Float)
+			return m_State.m_VsyncToPhotons;
+		return 0.0f;
+	}
+
+	// Not used by the code under test
+	void GetRecommendedRenderTargetSize(uint32_t *, uint32_t *) override {}
+	vr::HmdMatrix44_t GetProjectionMatrix(vr::EVREye, float, float) override { return {}; }
+	void GetProjectionRaw(vr::EVREye, float *, float *, float *, float *) override {}
+	bool ComputeDistortion(vr::EVREye, float, float, vr::DistortionCoordinates_t *) override { return false; }
+	vr::HmdMatrix34_t GetEyeToHeadTransform(vr::EVREye) override { return {}; }
+	bool GetTimeSinceLastVsync(float *, uint64_t *) override { return false; }
+	int32_t GetD3D9AdapterIndex() override { return {}; }
+	void GetDXGIOutputInfo(int32_t *) override {}
+	void GetOutputDevice(uint64_t *, vr::ETextureType, VkInstance_T *) override {}
+	bool IsDisplayOnDesktop() override { return false; }
+	bool SetDisplayVisibility(bool) override { return false; }
+	vr::HmdMatrix34_t GetSeatedZeroPoseToStandingAbsoluteTrackingPose() override { return {}; }
+	vr::HmdMatrix34_t GetRawZeroPoseToStandingAbsoluteTrackingPose() override { return {}; }
+	uint32_t GetSortedTrackedDeviceIndicesOfClass(vr::ETrackedDeviceClass, vr::TrackedDeviceIndex_t *, uint32_t, vr::TrackedDeviceIndex_t) override { return {}; }
+	vr::EDeviceActivityLevel GetTrackedDeviceActivityLevel(vr::TrackedDeviceIndex_t) override { return {}; }
+	void ApplyTransform(vr::TrackedDevicePose_t *, const vr::TrackedDevicePose_t *, const vr::HmdMatrix34_t *) override {}
+	vr::ETrackedControllerRole GetControllerRoleForTrackedDeviceIndex(vr::TrackedDeviceIndex_t) override { return {}; }
+	vr::ETrackedDeviceClass GetTrackedDeviceClass(vr::TrackedDeviceIndex_t) override { return {}; }
+	bool IsTrackedDeviceConnected(vr::TrackedDeviceIndex_t) override { return false; }
+	bool GetBoolTrackedDeviceProperty(vr::TrackedDeviceIndex_t, vr::ETrackedDeviceProperty, vr::ETrackedPropertyError *) override { return false; }
+	int32_t GetInt32TrackedDeviceProperty(vr::TrackedDeviceIndex_t, vr::ETrackedDeviceProperty, vr::ETrackedPropertyError *) override { return {}; }
+	uint64_t GetUint64TrackedDeviceProperty(vr::TrackedDeviceIndex_t, vr::ETrackedDeviceProperty, vr::ETrackedPropertyError *) override { return {}; }
+	vr::HmdMatrix34_t GetMatrix34TrackedDeviceProperty(vr::TrackedDeviceIndex_t, vr::ETrackedDeviceProperty, vr::ETrackedPropertyError *) override { return {}; }
+	uint32_t GetArrayTrackedDeviceProperty(vr::TrackedDeviceIndex_t, vr::ETrackedDeviceProperty, vr::PropertyTypeTag_t, void *, uint32_t, vr::ETrackedPropertyError *) override { return {}; }
+	uint32_t GetStringTrackedDeviceProperty(vr::TrackedDeviceIndex_t, vr::ETrackedDeviceProperty, char *, uint32_t, vr::ETrackedPropertyError *) override { return {}; }
+	const char *GetPropErrorNameFromEnum(vr::ETrackedPropertyError) override { return ""; }
+	bool PollNextEvent(vr::VREvent_t *, uint32_t) override { return false; }
+	bool PollNextEventWithPose(vr::ETrackingUniverseOrigin, vr::VREvent_t *, uint32_t, vr::TrackedDevicePose_t *) override { return false; }
+	const char *GetEventTypeNameFromEnum(vr::EVREventType) override { return ""; }
+	vr::HiddenAreaMesh_t GetHiddenAreaMesh(vr::EVREye, vr::EHiddenAreaMeshType) override { return {}; }
+	bool GetControllerState(vr::TrackedDeviceIndex_t, vr::VRControllerState_t *, uint32_t) override { return false; }
+	bool GetControllerStateWithPose(vr::ETrackingUniverseOrigin, vr::TrackedDeviceIndex_t, vr::VRControllerState_t *, uint32_t, vr::TrackedDevicePose_t *) override { return false; }
+	void TriggerHapticPulse(vr::TrackedDeviceIndex_t, uint32_t, unsigned short) override {}
+	const char *GetButtonIdNameFromEnum(vr::EVRButtonId) override { return ""; }
+	const char *GetControllerAxisTypeNameFromEnum(vr::EVRControllerAxisType) override { return ""; }
+	bool IsInputAvailable() override { return false; }
+	bool IsSteamVRDrawingControllers() override { return false; }
+	bool ShouldApplicationPause() override { return false; }
+	bool ShouldApplicationReduceRenderingWork() override { return false; }
+	vr::EVRFirmwareError PerformFirmwareUpdate(vr::TrackedDeviceIndex_t) override { return {}; }
+	void AcknowledgeQuit_Exiting() override {}
+	uint32_t GetAppContainerFilePaths(char *, uint32_t) override { return {}; }
+	const char *GetRuntimeVersion() override { return ""; }
+
+private:
+	MockVRState &m_State;
+};
+
+class MockVRCompositor : public vr::IVRCompositor
+{
+public:
+	explicit MockVRCompositor(MockVRState &state) : m_State(state) {}
+
+	vr::ETrackingUniverseOrigin GetTrackingSpace() override { return vr::TrackingUniverseStanding; }
+	// Returns right away for the next frame, predicted to its photons like the real one
+	vr::EVRCompositorError WaitGetPoses(vr::TrackedDevicePose_t *poses, uint32_t count, vr::TrackedDevicePose_t *, uint32_t) override
+	{
+		++m_State.m_Frame;
+		m_State.m_TimeInFrame = 0.0f;
+		m_State.FillPoses(m_State.Now() + GetFrameTimeRemaining() + m_State.m_VsyncToPhotons, poses, count);
+		return vr::VRCompositorError_None;
+	}
+
+	float GetFrameTimeRemaining() override { return m_State.m_FrameDuration - m_State.m_TimeInFrame; }
+
+	// Not used by the code under test
+	void SetTrackingSpace(vr::ETrackingUniverseOrigin) override {}
+	vr::EVRCompositorError GetLastPoses(vr::TrackedDevicePose_t *, uint32_t, vr::TrackedDevicePose_t *, uint32_t) override { return {}; }
+	vr::EVRCompositorError GetLastPoseForTrackedDeviceIndex(vr::TrackedDeviceIndex_t, vr::TrackedDevicePose_t *, vr::TrackedDevicePose_t *) override { return {}; }
+	vr::EVRCompositorError Submit(vr::EVREye, const vr::Texture_t *, const vr::VRTextureBounds_t *, vr::EVRSubmitFlags) override { return {}; }
+	void ClearLastSubmittedFrame() override {}
+	void PostPresentHandoff() override {}
+	bool GetFrameTiming(vr::Compositor_FrameTiming *, uint32_t) override { return false; }
+	uint32_t GetFrameTimings(vr::Compositor_FrameTiming *, uint32_t) override { return {}; }
+	void GetCumulativeStats(vr::Compositor_CumulativeStats *, uint32_t) override {}
+	void FadeToColor(float, float, float, float, float, bool) override {}
+	vr::HmdColor_t GetCurrentFadeColor(bool) override { return {}; }
+	void FadeGrid(float, bool) override {}
+	float GetCurrentGridAlpha() override { return {}; }
+	vr::EVRCompositorError SetSkyboxOverride(const vr::Texture_t *, uint32_t) override { return {}; }
+	void ClearSkyboxOverride() override {}
+	void CompositorBringToFront() override {}
+	void CompositorGoToBack() override {}
+	void CompositorQuit() override {}
+	bool IsFullscreen() override { return false; }
+	uint32_t GetCurrentSceneFocusProcess() override { return {}; }
+	uint32_t GetLastFrameRenderer() override { return {}; }
+	bool CanRenderScene() override { return false; }
+	void ShowMirrorWindow() override {}
+	void HideMirrorWindow() override {}
+	bool IsMirrorWindowVisible() override { return false; }
+	void CompositorDumpImages() override {}
+	bool ShouldAppRenderWithLowResources() override { return false; }
+	void ForceInterleavedReprojectionOn(bool) override {}
+	void ForceReconnectProcess() override {}
+	void SuspendRendering(bool) override {}
+	vr::EVRCompositorError GetMirrorTextureD3D11(vr::EVREye, void *, void **) override { return {}; }
+	void ReleaseMirrorTextureD3D11(void *) override {}
+	vr::EVRCompositorError GetMirrorTextureGL(vr::EVREye, vr::glUInt_t *, vr::glSharedTextureHandle_t *) override { return {}; }
+	bool ReleaseSharedGLTexture(vr::glUInt_t, vr::glSharedTextureHandle_t) override { return false; }
+	void LockGLSharedTextureForAccess(vr::glSharedTextureHandle_t) override {}
+	void UnlockGLSharedTextureForAccess(vr::glSharedTextureHandle_t) override {}
+	uint32_t GetVulkanInstanceExtensionsRequired(char *, uint32_t) override { return {}; }
+	uint32_t GetVulkanDeviceExtensionsRequired(VkPhysicalDevice_T *, char *, uint32_t) override { return {}; }
+	void SetExplicitTimingMode(vr::EVRCompositorTimingMode) override {}
+	vr::EVRCompositorError SubmitExplicitTimingData() override { return {}; }
+	bool IsMotionSmoothingEnabled() override { return false; }
+	bool IsMotionSmoothingSupported() override { return false; }
+	bool IsCurrentSceneFocusAppLoading() override { return false; }
+	vr::EVRCompositorError SetStageOverride_Async(const char *, const vr::HmdMatrix34_t *, const vr::Compositor_StageRenderSettings *, uint32_t) override { return {}; }
+	void ClearStageOverride() override {}
+	bool GetCompositorBenchmarkResults(vr::Compositor_BenchmarkResults *, uint32_t) override { return false; }
+	vr::EVRCompositorError GetLastPosePredictionIDs(uint32_t *, uint32_t *) override { return {}; }
+	vr::EVRCompositorError GetPosesForFrame(uint32_t, vr::TrackedDevicePose_t *, uint32_t) override { return {}; }
+
+private:
+	MockVRState &m_State;
+};
+
+class MockVRInput : public vr::IVRInput
+{
+public:
+	explicit MockVRInput(MockVRState &state) : m_State(state) {}
+
+	vr::EVRInputError UpdateActionState(vr::VRActiveActionSet_t *, uint32_t, uint32_t) override
+	{
+		++m_State.m_ActionStateUpdates;
+		return vr::VRInputError_None;
+	}
+
+	vr::EVRInputError GetDigitalActionData(vr::VRActionHandle_t action, vr::InputDigitalActionData_t *data, uint32_t, vr::VRInputValueHandle_t) override
+	{
+		const auto found = m_State.m_DigitalActions.find(action);
+		if (found == m_State.m_DigitalActions.end())
+			return vr::VRInputError_InvalidHandle;
+
+		*data = found->second;
+		return vr::VRInputError_None;
+	}
+
+	vr::EVRInputError GetAnalogActionData(vr::VRActionHandle_t action, vr::InputAnalogActionData_t *data, uint32_t, vr::VRInputValueHandle_t) override
+	{
+		const auto found = m_State.m_AnalogActions.find(action);
+		if (found == m_State.m_AnalogActions.end())
+			return vr::VRInputError_InvalidHandle;
+
+		*data = found->second;
+		return vr::VRInputError_None;
+	}
+
+	// Not used by the code under test
+	vr::EVRInputError SetActionManifestPath(const char *) override { return {}; }
+	vr::EVRInputError GetActionSetHandle(const char *, vr::VRActionSetHandle_t *) override { return {}; }
+	vr::EVRInputError GetActionHandle(const char *, vr::VRActionHandle_t *) override { return {}; }
+	vr::EVRInputError GetInputSourceHandle(const char *, vr::VRInputValueHandle_t *) override { return {}; }
+	vr::EVRInputError GetPoseActionDataRelativeToNow(vr::VRActionHandle_t, vr::ETrackingUniverseOrigin, float, vr::InputPoseActionData_t *, uint32_t, vr::VRInputValueHandle_t) override { return {}; }
+	vr::EVRInputError GetPoseActionDataForNextFrame(vr::VRActionHandle_t, vr::ETrackingUniverseOrigin, vr::InputPoseActionData_t *, uint32_t, vr::VRInputValueHandle_t) override { return {}; }
+	vr::EVRInputError GetSkeletalActionData(vr::VRActionHandle_t, vr::InputSkeletalActionData_t *, uint32_t) override { return {}; }
+	vr::EVRInputError GetDominantHand(vr::ETrackedControllerRole *) override { return {}; }
+	vr::EVRInputError SetDominantHand(vr::ETrackedControllerRole) override { return {}; }
+	vr::EVRInputError GetBoneCount(vr::VRActionHandle_t, uint32_t *) override { return {}; }
+	vr::EVRInputError GetBoneHierarchy(vr::VRActionHandle_t, vr::BoneIndex_t *, uint32_t) override { return {}; }
+	vr::EVRInputError GetBoneName(vr::VRActionHandle_t, vr::BoneIndex_t, char *, uint32_t) override { return {}; }
+	vr::EVRInputError GetSkeletalReferenceTransforms(vr::VRActionHandle_t, vr::EVRSkeletalTransformSpace, vr::EVRSkeletalReferencePose, vr::VRBoneTransform_t *, uint32_t) override { return {}; }
+	vr::EVRInputError GetSkeletalTrackingLevel(vr::VRActionHandle_t, vr::EVRSkeletalTrackingLevel *) override { return {}; }
+	vr::EVRInputError GetSkeletalBoneData(vr::VRActionHandle_t, vr::EVRSkeletalTransformSpace, vr::EVRSkeletalMotionRange, vr::VRBoneTransform_t *, uint32_t) override { return {}; }
+	vr::EVRInputError GetSkeletalSummaryData(vr::VRActionHandle_t, vr::EVRSummaryType, vr::VRSkeletalSummaryData_t *) override { return {}; }
+	vr::EVRInputError GetSkeletalBoneDataCompressed(vr::VRActionHandle_t, vr::EVRSkeletalMotionRange, void *, uint32_t, uint32_t *) override { return {}; }
+	vr::EVRInputError DecompressSkeletalBoneData(const void *, uint32_t, vr::EVRSkeletalTransformSpace, vr::VRBoneTransform_t *, uint32_t) override { return {}; }
+	vr::EVRInputError TriggerHapticVibrationAction(vr::VRActionHandle_t, float, float, float, float, vr::VRInputValueHandle_t) override { return {}; }
+	vr::EVRInputError GetActionOrigins(vr::VRActionSetHandle_t, vr::VRActionHandle_t, vr::VRInputValueHandle_t *, uint32_t) override { return {}; }
+	vr::EVRInputError GetOriginLocalizedName(vr::VRInputValueHandle_t, char *, uint32_t, int32_t) override { return {}; }
+	vr::EVRInputError GetOriginTrackedDeviceInfo(vr::VRInputValueHandle_t, vr::InputOriginInfo_t *, uint32_t) override { return {}; }
+	vr::EVRInputError GetActionBindingInfo(vr::VRActionHandle_t, vr::InputBindingInfo_t *, uint32_t, uint32_t, uint32_t *) override { return {}; }
+	vr::EVRInputError ShowActionOrigins(vr::VRActionSetHandle_t, vr::VRActionHandle_t) override { return {}; }
+	vr::EVRInputError ShowBindingsForActionSet(vr::VRActiveActionSet_t *, uint32_t, uint32_t, vr::VRInputValueHandle_t) override { return {}; }
+	vr::EVRInputError GetComponentStateForBinding(const char *, const char *, const vr::InputBindingInfo_t *, uint32_t, uint32_t, vr::RenderModel_ComponentState_t *) override { return {}; }
+	bool IsUsingLegacyInput() override { return false; }
+	vr::EVRInputError OpenBindingUI(const char *, vr::VRActionSetHandle_t, vr::VRInputValueHandle_t, bool) override { return {}; }
+	vr::EVRInputError GetBindingVariant(vr::VRInputValueHandle_t, char *, uint32_t) override { return {}; }
+
+private:
+	MockVRState &m_State;
+};
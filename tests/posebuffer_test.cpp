@@ -0,0 +1,125 @@
+// A mock tracking thread publishes pose snapshots as fast as it can while readers latch them concurrently.
+// Every snapshot is filled from its frame index, so a torn read shows up as a mismatch.
+#include "posebuffer.h"
+#include <atomic>
+#include <cstdio>
+#include <thread>
+#include <vector>
+
+namespace
+{
+	constexpr uint64_t NUM_FRAMES = 2000000;
+	constexpr size_t NUM_READERS = 2;
+	constexpr size_t NUM_VALUES = 64;	// Roughly the size of a few tracked device poses
+
+	struct MockSnapshot
+	{
+		uint64_t m_FrameIndex;
+		float m_Values[NUM_VALUES];
+		uint64_t m_Check;
+	};
+
+	void Fill(MockSnapshot &snapshot, uint64_t frameIndex)
+	{
+		snapshot.m_FrameIndex = frameIndex;
+		for (size_t i = 0; i < NUM_VALUES; ++i)
+			snapshot.m_Values[i] = (float)((frameIndex + i) % 65536);
+		snapshot.m_Check = ~frameIndex;
+	}
+
+	bool IsConsistent(const MockSnapshot &snapshot)
+	{
+		if (snapshot.m_Check != ~snapshot.m_FrameIndex)
+			return false;
+
+		for (size_t i = 0; i < NUM_VALUES; ++i)
+		{
+			if (snapshot.m_Values[i] != (float)((snapshot.m_FrameIndex + i) % 65536))
+				return false;
+		}
+		return true;
+	}
+
+	int g_Failures = 0;
+
+	void Expect(bool condition, const char *what)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", what);
+			++g_Failures;
+		}
+	}
+}
+
+int main()
+{
+	// Nothing published yet
+	{
+		SeqLockTripleBuffer<MockSnapshot> buffer;
+		MockSnapshot snapshot;
+		Expect(!buffer.Read(snapshot), "Read fails before the first Publish");
+
+		Fill(snapshot, 7);
+		buffer.Publish(snapshot);
+		MockSnapshot latched = {};
+		Expect(buffer.Read(latched) && latched.m_FrameIndex == 7 && IsConsistent(latched), "Read returns the published snapshot");
+	}
+
+	// Producer and readers racing
+	SeqLockTripleBuffer<MockSnapshot> buffer;
+	std::atomic<bool> producing = true;
+	std::atomic<int> torn = 0;
+	std::atomic<int> backwards = 0;
+	std::atomic<uint64_t> reads = 0;
+
+	std::thread producer([&]()
+	{
+		MockSnapshot snapshot;
+		for (uint64_t frame = 1; frame <= NUM_FRAMES; ++frame)
+		{
+			Fill(snapshot, frame);
+			buffer.Publish(snapshot);
+		}
+		producing = false;
+	});
+
+	std::vector<std::thread> readers;
+	for (size_t r = 0; r < NUM_READERS; ++r)
+	{
+		readers.emplace_back([&]()
+		{
+			MockSnapshot snapshot;
+			uint64_t lastFrame = 0;
+			uint64_t count = 0;
+
+			while (producing.load())
+			{
+				if (!buffer.Read(snapshot))
+					continue;
+
+				++count;
+				if (!IsConsistent(snapshot))
+					++torn;
+				if (snapshot.m_FrameIndex < lastFrame)
+					++backwards;
+				lastFrame = snapshot.m_FrameIndex;
+			}
+			reads += count;
+		});
+	}
+
+	producer.join();
+	for (std::thread &reader : readers)
+		reader.join();
+
+	MockSnapshot last;
+	Expect(buffer.Read(last) && last.m_FrameIndex == NUM_FRAMES && IsConsistent(last), "The last published snapshot is readable");
+	Expect(torn == 0, "No torn snapshots");
+	Expect(backwards == 0, "Readers never see an older snapshot after a newer one");
+
+	printf("%llu frames published, %llu reads, %d torn, %d out of order\n",
+		(unsigned long long)NUM_FRAMES, (unsigned long long)reads.load(), torn.load(), backwards.load());
+
+	return g_Failures == 0 ? 0 : 1;
+}
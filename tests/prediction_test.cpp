@@ -0,0 +1,191 @@
+// PredictPose checks, plus a replay harness: a synthetic head motion is "tracked" at 90 Hz, every frame's pose is
+// predicted to when that frame actually reaches the display and compared against the true motion at that time.
+#include "prediction.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	constexpr float PI = 3.14159265358979f;
+
+	int g_Failures = 0;
+
+	void Expect(bool condition, const char *what)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", what);
+			++g_Failures;
+		}
+	}
+
+	bool Near(float a, float b, float epsilon = 1e-4f)
+	{
+		return fabsf(a - b) <= epsilon;
+	}
+
+	vr::TrackedDevicePose_t MakePose(float yaw, const float position[3], float yawRate, const float velocity[3])
+	{
+		vr::TrackedDevicePose_t pose = {};
+		pose.bPoseIsValid = true;
+		pose.eTrackingResult = vr::TrackingResult_Running_OK;
+
+		// Rotation around the tracking space Y axis
+		vr::HmdMatrix34_t &m = pose.mDeviceToAbsoluteTracking;
+		m.m[0][0] = cosf(yaw);	m.m[0][1] = 0;	m.m[0][2] = sinf(yaw);
+		m.m[1][0] = 0;			m.m[1][1] = 1;	m.m[1][2] = 0;
+		m.m[2][0] = -sinf(yaw);	m.m[2][1] = 0;	m.m[2][2] = cosf(yaw);
+
+		for (int i = 0; i < 3; ++i)
+		{
+			m.m[i][3] = position[i];
+			pose.vVelocity.v[i] = velocity[i];
+		}
+		pose.vAngularVelocity.v[1] = yawRate;
+		return pose;
+	}
+
+	// Angle in degrees between the rotations of two poses
+	float RotationError(const vr::TrackedDevicePose_t &a, const vr::TrackedDevicePose_t &b)
+	{
+		float trace = 0.0f;
+		for (int row = 0; row < 3; ++row)
+		{
+			for (int col = 0; col < 3; ++col)
+				trace += a.mDeviceToAbsoluteTracking.m[row][col] * b.mDeviceToAbsoluteTracking.m[row][col];
+		}
+		return acosf(std::clamp((trace - 1.0f) * 0.5f, -1.0f, 1.0f)) * 180.0f / PI;
+	}
+
+	float PositionError(const vr::TrackedDevicePose_t &a, const vr::TrackedDevicePose_t &b)
+	{
+		float sum = 0.0f;
+		for (int i = 0; i < 3; ++i)
+		{
+			const float d = a.mDeviceToAbsoluteTracking.m[i][3] - b.mDeviceToAbsoluteTracking.m[i][3];
+			sum += d * d;
+		}
+		return sqrtf(sum);
+	}
+
+	bool IsOrthonormal(const vr::HmdMatrix34_t &m)
+	{
+		for (int a = 0; a < 3; ++a)
+		{
+			for (int b = 0; b < 3; ++b)
+			{
+				const float dot = m.m[0][a] * m.m[0][b] + m.m[1][a] * m.m[1][b] + m.m[2][a] * m.m[2][b];
+				if (!Near(dot, a == b ? 1.0f : 0.0f))
+					return false;
+			}
+		}
+		return true;
+	}
+
+	void TestPredictPose()
+	{
+		const float position[3] = { 1.0f, 1.7f, -0.5f };
+		const float velocity[3] = { 0.5f, -0.2f, 1.0f };
+		const vr::TrackedDevicePose_t pose = MakePose(0.3f, position, 2.0f, velocity);
+
+		const vr::TrackedDevicePose_t same = PredictPose(pose, 0.0f);
+		Expect(RotationError(same, pose) < 1e-3f && PositionError(same, pose) == 0.0f, "Zero seconds leaves the pose alone");
+
+		vr::TrackedDevicePose_t invalid = pose;
+		invalid.bPoseIsValid = false;
+		Expect(PositionError(PredictPose(invalid, 0.05f), invalid) == 0.0f, "Invalid poses aren't extrapolated");
+
+		// Constant velocities are extrapolated exactly
+		const float t = 0.05f;
+		const float expectedPosition[3] = { position[0] + velocity[0] * t, position[1] + velocity[1] * t, position[2] + velocity[2] * t };
+		const vr::TrackedDevicePose_t expected = MakePose(0.3f + 2.0f * t, expectedPosition, 2.0f, velocity);
+		const vr::TrackedDevicePose_t predicted = PredictPose(pose, t);
+		Expect(RotationError(predicted, expected) < 0.01f, "Yaw advances by angular velocity * seconds");
+		Expect(PositionError(predicted, expected) < 1e-5f, "Position advances by velocity * seconds");
+		Expect(IsOrthonormal(predicted.mDeviceToAbsoluteTracking), "Predicted rotation stays orthonormal");
+
+		// Integrating in two steps lands on the same pose as one step
+		const vr::TrackedDevicePose_t twoSteps = PredictPose(PredictPose(pose, 0.02f), 0.03f);
+		Expect(RotationError(twoSteps, predicted) < 0.01f && PositionError(twoSteps, predicted) < 1e-5f, "Prediction composes");
+
+		// Rotation around an arbitrary axis, half a turn around X flips Y and Z
+		vr::TrackedDevicePose_t spinning = MakePose(0.0f, position, 0.0f, velocity);
+		spinning.vAngularVelocity.v[0] = PI;
+		const vr::HmdMatrix34_t &flipped = PredictPose(spinning, 1.0f).mDeviceToAbsoluteTracking;
+		Expect(Near(flipped.m[0][0], 1.0f) && Near(flipped.m[1][1], -1.0f) && Near(flipped.m[2][2], -1.0f), "Half a turn around X");
+
+		const vr::TrackedDevicePose_t backwards = PredictPose(predicted, -t);
+		Expect(RotationError(backwards, pose) < 0.01f && PositionError(backwards, pose) < 1e-5f, "Negative seconds extrapolate backwards");
+	}
+
+	// Head shaking left and right while stepping sideways
+	vr::TrackedDevicePose_t TrueMotion(float t)
+	{
+		const float yawFrequency = 1.5f * 2.0f * PI;
+		const float yawAmplitude = 0.6f;
+		const float moveFrequency = 0.5f * 2.0f * PI;
+		const float moveAmplitude = 0.3f;
+
+		const float position[3] = { moveAmplitude * sinf(moveFrequency * t), 1.7f, 0.0f };
+		const float velocity[3] = { moveAmplitude * moveFrequency * cosf(moveFrequency * t), 0.0f, 0.0f };
+		return MakePose(yawAmplitude * sinf(yawFrequency * t), position, yawAmplitude * yawFrequency * cosf(yawFrequency * t), velocity);
+	}
+
+	struct ReplayError
+	{
+		float rotation = 0.0f;
+		float position = 0.0f;
+
+		void Add(const vr::TrackedDevicePose_t &pose, const vr::TrackedDevicePose_t &truth)
+		{
+			rotation += RotationError(pose, truth);
+			position += PositionError(pose, truth);
+		}
+	};
+
+	void TestReplay()
+	{
+		const float frameDuration = 1.0f / 90.0f;
+		const int numFrames = 900;
+		const float poseAge = 0.006f;	// Time between WaitGetPoses returning and the frame's view being built
+
+		ReplayError none, photonTime, doublePredicted;
+		int missed = 0;
+
+		for (int frame = 0; frame < numFrames; ++frame)
+		{
+			// The compositor predicts the poses to this frame's photons
+			const float predictedFor = frame * frameDuration;
+			const vr::TrackedDevicePose_t poses = TrueMotion(predictedFor);
+
+			// Every 7th frame misses its vsync and is displayed a frame later
+			const float lateBy = (frame % 7 == 3) ? frameDuration : 0.0f;
+			missed += lateBy > 0.0f;
+			const vr::TrackedDevicePose_t truth = TrueMotion(predictedFor + lateBy);
+
+			none.Add(poses, truth);
+			photonTime.Add(PredictPose(poses, std::min(lateBy, MAX_PREDICTION_SECONDS)), truth);
+			doublePredicted.Add(PredictPose(poses, std::min(poseAge + lateBy, MAX_PREDICTION_SECONDS)), truth);
+		}
+
+		printf("Replay of %d frames, %d displayed late. Mean error (deg / mm):\n", numFrames, missed);
+		printf("  no prediction            %7.3f / %7.3f\n", none.rotation / numFrames, none.position * 1000.0f / numFrames);
+		printf("  to photon time           %7.3f / %7.3f\n", photonTime.rotation / numFrames, photonTime.position * 1000.0f / numFrames);
+		printf("  pose age on top (before) %7.3f / %7.3f\n", doublePredicted.rotation / numFrames, doublePredicted.position * 1000.0f / numFrames);
+
+		Expect(photonTime.rotation < none.rotation * 0.5f, "Predicting late frames to their photons cuts the rotation error");
+		Expect(photonTime.position < none.position * 0.5f, "Predicting late frames to their photons cuts the position error");
+		Expect(photonTime.rotation < doublePredicted.rotation, "Predicting the pose age on top overshoots");
+	}
+}
+
+int main()
+{
+	TestPredictPose();
+	TestReplay();
+
+	if (g_Failures == 0)
+		printf("All prediction tests passed\n");
+	return g_Failures == 0 ? 0 : 1;
+}
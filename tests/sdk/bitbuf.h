@@ -0,0 +1,169 @@
+#pragma once
+#include "coordsize.h"
+#include "vector.h"
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+
+// Stand-in for the parts of the Source SDK's bf_write and bf_read that vrusercmd.cpp uses. The SDK's bitbuf
+// only builds with MSVC, this one produces the same number of bits for every call, so sizes measured with it
+// are what goes over the wire. Bits are stored LSB first like the SDK's.
+
+class bf_write
+{
+public:
+	// Cleared up front, so partially written bytes never hold garbage
+	bf_write(void *data, int bytes) : m_Data((uint8_t *)data), m_NumBits(bytes * 8) { memset(data, 0, bytes); }
+
+	void WriteOneBit(int value)
+	{
+		if (m_CurBit >= m_NumBits)
+		{
+			m_Overflow = true;
+			return;
+		}
+
+		if (value)
+			m_Data[m_CurBit >> 3] |= 1 << (m_CurBit & 7);
+		else
+			m_Data[m_CurBit >> 3] &= ~(1 << (m_CurBit & 7));
+		++m_CurBit;
+	}
+
+	void WriteUBitLong(unsigned int value, int numBits)
+	{
+		for (int i = 0; i < numBits; ++i)
+			WriteOneBit((value >> i) & 1);
+	}
+
+	void WriteSBitLong(int value, int numBits) { WriteUBitLong((unsigned int)value, numBits); }
+	void WriteChar(int value) { WriteSBitLong(value, 8); }
+
+	void WriteBits(const void *data, int numBits)
+	{
+		const uint8_t *bytes = (const uint8_t *)data;
+		for (int i = 0; i < numBits; ++i)
+			WriteOneBit((bytes[i >> 3] >> (i & 7)) & 1);
+	}
+
+	// Same encoding as the SDK: integer and fraction flags, then sign, integer and fraction if present
+	void WriteBitCoord(float f)
+	{
+		const int sign = f <= -COORD_RESOLUTION;
+		int intval = (int)fabsf(f);
+		const int fractval = abs((int)(f * COORD_DENOMINATOR)) & (COORD_DENOMINATOR - 1);
+
+		WriteOneBit(intval);
+		WriteOneBit(fractval);
+
+		if (intval || fractval)
+		{
+			WriteOneBit(sign);
+			if (intval)
+				WriteUBitLong(intval - 1, COORD_INTEGER_BITS);
+			if (fractval)
+				WriteUBitLong(fractval, COORD_FRACTIONAL_BITS);
+		}
+	}
+
+	void WriteBitVec3Coord(const Vector &v)
+	{
+		bool nonZero[3];
+		for (int i = 0; i < 3; ++i)
+		{
+			nonZero[i] = v[i] >= COORD_RESOLUTION || v[i] <= -COORD_RESOLUTION;
+			WriteOneBit(nonZero[i]);
+		}
+
+		for (int i = 0; i < 3; ++i)
+		{
+			if (nonZero[i])
+				WriteBitCoord(v[i]);
+		}
+	}
+
+	void WriteBitAngles(const QAngle &angles) { WriteBitVec3Coord(Vector(angles.x, angles.y, angles.z)); }
+
+	int GetNumBitsWritten() const { return m_CurBit; }
+	bool IsOverflowed() const { return m_Overflow; }
+
+private:
+	uint8_t *m_Data;
+	int m_NumBits;
+	int m_CurBit = 0;
+	bool m_Overflow = false;
+};
+
+class bf_read
+{
+public:
+	bf_read(const void *data, int bytes) : m_Data((const uint8_t *)data), m_NumBits(bytes * 8) {}
+
+	int ReadOneBit()
+	{
+		if (m_CurBit >= m_NumBits)
+		{
+			m_Overflow = true;
+			return 0;
+		}
+
+		const int bit = (m_Data[m_CurBit >> 3] >> (m_CurBit & 7)) & 1;
+		++m_CurBit;
+		return bit;
+	}
+
+	unsigned int ReadUBitLong(int numBits)
+	{
+		unsigned int value = 0;
+		for (int i = 0; i < numBits; ++i)
+			value |= (unsigned int)ReadOneBit() << i;
+		return value;
+	}
+
+	int ReadSBitLong(int numBits)
+	{
+		const unsigned int value = ReadUBitLong(numBits);
+		return numBits < 32 && (value & (1u << (numBits - 1))) ? (int)(value | (~0u << numBits)) : (int)value;
+	}
+
+	int ReadChar() { return ReadSBitLong(8); }
+
+	float ReadBitCoord()
+	{
+		const int hasInt = ReadOneBit();
+		const int hasFract = ReadOneBit();
+		if (!hasInt && !hasFract)
+			return 0.0f;
+
+		const int sign = ReadOneBit();
+		const int intval = hasInt ? (int)ReadUBitLong(COORD_INTEGER_BITS) + 1 : 0;
+		const int fractval = hasFract ? (int)ReadUBitLong(COORD_FRACTIONAL_BITS) : 0;
+
+		const float value = intval + fractval * (float)COORD_RESOLUTION;
+		return sign ? -value : value;
+	}
+
+	int Tell() const { return m_CurBit; }
+
+	bool Seek(int bit)
+	{
+		if (bit < 0 || bit > m_NumBits)
+		{
+			m_Overflow = true;
+			m_CurBit = m_NumBits;
+			return false;
+		}
+
+		m_CurBit = bit;
+		return true;
+	}
+
+	bool IsOverflowed() const { return m_Overflow; }
+
+private:
+	const uint8_t *m_Data;
+	int m_NumBits;
+	int m_CurBit = 0;
+	bool m_Overflow = false;
+};
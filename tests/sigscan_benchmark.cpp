@@ -0,0 +1,160 @@
+// Compares the batched anchor-filtered scan against scanning for one signature at a time, over a synthetic
+// buffer with a byte distribution roughly like x86 code. Fails if any scan disagrees with the reference.
+#include "sigmatch.h"
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace
+{
+	constexpr size_t BUFFER_SIZE = 32 * 1024 * 1024;
+	constexpr size_t NUM_PRESENT = 48;
+	constexpr size_t NUM_MISSING = 16;
+
+	const uint8_t COMMON_BYTES[] = { 0x00, 0xFF, 0xCC, 0x8B, 0x55, 0x89, 0xE8, 0x83, 0xEC, 0x56, 0x57, 0x53 };
+
+	std::vector<uint8_t> MakeBuffer(std::mt19937 &rng)
+	{
+		std::vector<uint8_t> buffer(BUFFER_SIZE);
+		std::uniform_int_distribution<int> byte(0, 255);
+		std::uniform_int_distribution<int> common(0, (int)std::size(COMMON_BYTES) - 1);
+		std::bernoulli_distribution pickCommon(0.4);
+
+		for (uint8_t &b : buffer)
+			b = pickCommon(rng) ? COMMON_BYTES[common(rng)] : (uint8_t)byte(rng);
+		return buffer;
+	}
+
+	// Signature text for buffer[offset, offset + length), with some bytes turned into wildcards
+	std::string MakeSignatureText(const std::vector<uint8_t> &buffer, size_t offset, size_t length, std::mt19937 &rng)
+	{
+		std::bernoulli_distribution wildcard(0.2);
+		std::string text;
+		char hex[4];
+
+		for (size_t i = 0; i < length; ++i)
+		{
+			if (i > 0)
+				text += ' ';
+
+			// First byte stays fixed so signatures can't start with a wildcard run
+			if (i > 0 && wildcard(rng))
+			{
+				text += '?';
+				continue;
+			}
+
+			snprintf(hex, sizeof(hex), "%02X", buffer[offset + i]);
+			text += hex;
+		}
+		return text;
+	}
+
+	// How the scanner worked before batching: one full pass over the buffer per signature
+	int64_t ScanOne(const std::vector<uint8_t> &buffer, const Signature &sig)
+	{
+		for (size_t offset = 0; offset + sig.length <= buffer.size(); ++offset)
+		{
+			if (SigMatch::MatchesAt(buffer.data(), buffer.size(), offset, sig))
+				return (int64_t)offset;
+		}
+		return INT64_MAX;
+	}
+
+	template <typename Fn>
+	double TimeMs(Fn fn)
+	{
+		const auto start = std::chrono::steady_clock::now();
+		fn();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+	bool CpuSupportsAVX2()
+	{
+#if defined(__GNUC__)
+		return __builtin_cpu_supports("avx2");
+#else
+		return false;
+#endif
+	}
+}
+
+int main()
+{
+	std::mt19937 rng(1234);
+	const std::vector<uint8_t> buffer = MakeBuffer(rng);
+
+	std::vector<std::string> texts;
+	std::uniform_int_distribution<size_t> offsetDist(0, BUFFER_SIZE - 64);
+	std::uniform_int_distribution<size_t> lengthDist(12, 40);
+
+	for (size_t i = 0; i < NUM_PRESENT + NUM_MISSING; ++i)
+	{
+		const size_t offset = offsetDist(rng);
+		std::string text = MakeSignatureText(buffer, offset, lengthDist(rng), rng);
+
+		// Flip the first byte so the rest of the pattern almost certainly occurs nowhere
+		if (i >= NUM_PRESENT)
+		{
+			char hex[3];
+			snprintf(hex, sizeof(hex), "%02X", buffer[offset] ^ 0x5A);
+			text[0] = hex[0];
+			text[1] = hex[1];
+		}
+		texts.push_back(text);
+	}
+
+	std::vector<Signature> signatures;
+	for (const std::string &text : texts)
+		signatures.push_back(SigScanner::CompileSignature(text.c_str()));
+
+	std::vector<int64_t> expected(signatures.size());
+	const double oneByOneMs = TimeMs([&]()
+	{
+		for (size_t i = 0; i < signatures.size(); ++i)
+			expected[i] = ScanOne(buffer, signatures[i]);
+	});
+
+	bool ok = true;
+	const auto runBatched = [&](const char *name, bool useAVX2, size_t numWorkers)
+	{
+		auto scan = std::make_unique<SigMatch::PatternScan>();
+		scan->Reset(buffer.data(), buffer.size());
+		for (size_t i = 0; i < signatures.size(); ++i)
+			scan->Add(&signatures[i], (uint8_t)i);
+
+		const double ms = TimeMs([&]()
+		{
+			SigMatch::Prepare(*scan);
+			SigMatch::Scan(*scan, useAVX2, numWorkers);
+		});
+
+		for (size_t p = 0; p < scan->numPatterns; ++p)
+		{
+			const int64_t found = scan->found[p].load();
+			if (found != expected[scan->tags[p]])
+			{
+				printf("%s: signature %u found at %lld, expected %lld\n", name, (unsigned)scan->tags[p], (long long)found, (long long)expected[scan->tags[p]]);
+				ok = false;
+			}
+		}
+
+		printf("%-22s %9.2f ms  %6.1fx\n", name, ms, oneByOneMs / ms);
+	};
+
+	printf("%zu MB, %zu signatures (%zu not present)\n", BUFFER_SIZE / (1024 * 1024), signatures.size(), NUM_MISSING);
+	printf("%-22s %9.2f ms\n", "one by one", oneByOneMs);
+
+	runBatched("batched SSE2, 1 thread", false, 1);
+	runBatched("batched SSE2", false, 0);
+	if (CpuSupportsAVX2())
+	{
+		runBatched("batched AVX2, 1 thread", true, 1);
+		runBatched("batched AVX2", true, 0);
+	}
+
+	return ok ? 0 : 1;
+}
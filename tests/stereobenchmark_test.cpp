@@ -0,0 +1,87 @@
+// StereoBenchmark block alternation, warm-up frames and the statistics it reports for each variant.
+#include "stereobenchmark.h"
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Expect(bool condition, const char *what)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", what);
+			++g_Failures;
+		}
+	}
+
+	bool Near(double a, double b)
+	{
+		return fabs(a - b) <= 1e-9;
+	}
+
+	void TestAlternation()
+	{
+		StereoBenchmark benchmark;
+		Expect(!benchmark.IsRunning() && !benchmark.AddFrame(1), "idle benchmark ignores frames");
+
+		benchmark.Start(3, 4, 1);
+		Expect(benchmark.IsRunning(), "started");
+
+		// Blocks of 3 frames: separate, shared, separate, shared
+		const bool expected[12] = { false, false, false, true, true, true, false, false, false, true, true, true };
+		for (int frame = 0; frame < 12; ++frame)
+		{
+			char what[64];
+			snprintf(what, sizeof(what), "frame %d uses the right variant", frame);
+			Expect(benchmark.SharedPasses() == expected[frame], what);
+
+			const bool last = benchmark.AddFrame(1000000);
+			snprintf(what, sizeof(what), "frame %d %s the run", frame, frame == 11 ? "ends" : "doesn't end");
+			Expect(last == (frame == 11), what);
+		}
+
+		Expect(!benchmark.IsRunning(), "stops after the last block");
+		Expect(benchmark.GetResult(false).m_Frames == 4 && benchmark.GetResult(true).m_Frames == 4,
+			"the first frame of every block is dropped");
+	}
+
+	void TestStatistics()
+	{
+		StereoBenchmark benchmark;
+		benchmark.Start(100, 2, 0);
+
+		// 1..100 ms without sharing, half of that with
+		for (int frame = 1; frame <= 100; ++frame)
+			benchmark.AddFrame(frame * 1000000ull);
+		for (int frame = 1; frame <= 100; ++frame)
+			benchmark.AddFrame(frame * 500000ull);
+
+		const StereoBenchmark::Result separate = benchmark.GetResult(false);
+		const StereoBenchmark::Result shared = benchmark.GetResult(true);
+		Expect(separate.m_Frames == 100 && shared.m_Frames == 100, "every frame counted");
+		Expect(Near(separate.m_MeanMs, 50.5) && Near(shared.m_MeanMs, 25.25), "mean");
+		Expect(Near(separate.m_P50Ms, 51.0) && Near(separate.m_P95Ms, 96.0), "percentiles");
+		Expect(Near(shared.m_P50Ms, 25.5) && Near(shared.m_P95Ms, 48.0), "percentiles of the shared variant");
+
+		// Starting again forgets the last run
+		benchmark.Start(10, 2, 0);
+		Expect(benchmark.GetResult(false).m_Frames == 0 && benchmark.GetResult(true).m_MeanMs == 0.0, "restart clears the results");
+	}
+}
+
+int main()
+{
+	TestAlternation();
+	TestStatistics();
+
+	if (g_Failures)
+	{
+		printf("%d check(s) failed\n", g_Failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
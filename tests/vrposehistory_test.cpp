@@ -0,0 +1,214 @@
+// VRPoseHistory ordering and interpolation, and which pose PlayerVRTable::BeginFire aims a shot with.
+#include "playervrtable.h"
+#include "vrposehistory.h"
+#include <cmath>
+#include <cstdio>
+
+namespace
+{
+	int g_Failures = 0;
+
+	void Expect(bool condition, const char *what)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", what);
+			++g_Failures;
+		}
+	}
+
+	bool Near(float a, float b, float epsilon = 1e-4f)
+	{
+		return fabsf(a - b) <= epsilon;
+	}
+
+	bool Near(const Vector &a, const Vector &b)
+	{
+		return Near(a.x, b.x) && Near(a.y, b.y) && Near(a.z, b.z);
+	}
+
+	bool Near(const QAngle &a, const QAngle &b)
+	{
+		return Near(a.x, b.x) && Near(a.y, b.y) && Near(a.z, b.z);
+	}
+
+	// A pose that's easy to tell apart by tick
+	Vector PosAt(int tick)
+	{
+		return Vector(tick * 1.0f, tick * -2.0f, 64.0f);
+	}
+
+	QAngle AngleAt(int tick)
+	{
+		return QAngle(tick * 0.5f, tick * 3.0f, 0.0f);
+	}
+
+	void Add(VRPoseHistory &history, int tick)
+	{
+		history.Add(tick, PosAt(tick), AngleAt(tick));
+	}
+
+	void TestSample()
+	{
+		VRPoseHistory history;
+		Vector pos;
+		QAngle angle;
+		Expect(!history.Sample(10.0f, pos, angle), "empty history has nothing to sample");
+
+		Add(history, 10);
+		Expect(history.Sample(3.0f, pos, angle) && Near(pos, PosAt(10)), "single sample before it");
+		Expect(history.Sample(30.0f, pos, angle) && Near(pos, PosAt(10)), "single sample after it");
+
+		Add(history, 12);
+		Add(history, 16);
+
+		Expect(history.Sample(12.0f, pos, angle) && Near(pos, PosAt(12)) && Near(angle, AngleAt(12)), "exact tick");
+		Expect(history.Sample(14.0f, pos, angle) && Near(pos, PosAt(14)) && Near(angle, AngleAt(14)), "between ticks");
+		Expect(history.Sample(11.25f, pos, angle) && Near(pos, Vector(11.25f, -22.5f, 64.0f)), "fractional tick");
+		Expect(history.Sample(5.0f, pos, angle) && Near(pos, PosAt(10)) && Near(angle, AngleAt(10)), "clamped to the oldest");
+		Expect(history.Sample(20.0f, pos, angle) && Near(pos, PosAt(16)) && Near(angle, AngleAt(16)), "clamped to the newest");
+
+		// Yaw wrapping from 170 to -170 goes through 180, not through 0
+		VRPoseHistory wrap;
+		wrap.Add(0, Vector(0, 0, 0), QAngle(0.0f, 170.0f, -175.0f));
+		wrap.Add(2, Vector(0, 0, 0), QAngle(0.0f, -170.0f, 175.0f));
+		Expect(wrap.Sample(1.0f, pos, angle), "wrapping sample");
+		Expect(Near(fabsf(remainderf(angle.y, 360.0f)), 180.0f) && Near(fabsf(remainderf(angle.z, 360.0f)), 180.0f),
+			"angles take the short way around");
+		Expect(wrap.Sample(0.5f, pos, angle) && Near(angle.y, 175.0f), "a quarter of the way around");
+	}
+
+	void TestOrdering()
+	{
+		VRPoseHistory history;
+		Add(history, 20);
+		Add(history, 10);
+		Add(history, 15);
+		Expect(history.OldestTick() == 10 && history.NewestTick() == 20, "late samples are inserted in order");
+
+		Vector pos;
+		QAngle angle;
+		Expect(history.Sample(12.5f, pos, angle) && Near(pos, PosAt(12) + (PosAt(13) - PosAt(12)) * 0.5f), "interpolates across an inserted sample");
+
+		// Resent commands overwrite the sample they had
+		history.Add(15, Vector(1, 2, 3), QAngle(0, 0, 0));
+		Expect(history.Sample(15.0f, pos, angle) && Near(pos, Vector(1, 2, 3)), "same tick overwrites");
+
+		// A full history drops the oldest sample, and ignores ones older than everything it has
+		VRPoseHistory full;
+		for (int tick = 100; tick < 200; ++tick)
+			Add(full, tick);
+
+		const int oldest = full.OldestTick();
+		Expect(full.NewestTick() == 199 && oldest > 100, "full history keeps the newest samples");
+
+		Add(full, 50);
+		Expect(full.OldestTick() == oldest, "sample older than a full history is dropped");
+
+		full.Clear();
+		Expect(full.IsEmpty() && !full.Sample(150.0f, pos, angle), "cleared history is empty");
+	}
+
+	// Feeds one usercmd the way dReadUsercmd does
+	void Usercmd(PlayerVRTable &players, int slot, int tick, bool firing)
+	{
+		players.SetUsingVR(slot, true);
+		players.m_ControllerPos[slot] = PosAt(tick);
+		players.m_ControllerAngle[slot] = AngleAt(tick);
+		players.AddUsercmd(slot, tick, firing);
+	}
+
+	// BeginFire outside of PlayerRunCommand, the newest command with fire down stands in for the one being simulated
+	void TestFirePose()
+	{
+		constexpr int SLOT = 3;
+		PlayerVRTable players;
+
+		// Not firing yet, shots aim with the latest pose
+		for (int tick = 1; tick <= 5; ++tick)
+			Usercmd(players, SLOT, tick, false);
+
+		players.BeginFire(SLOT);
+		Expect(Near(players.AimControllerPos(SLOT), PosAt(5)), "no fire command aims with the latest pose");
+		players.EndFire(SLOT);
+
+		// Fire pressed on tick 6 and held, every held command can fire and has to aim with its own pose
+		Usercmd(players, SLOT, 6, true);
+		Usercmd(players, SLOT, 7, false);
+		players.BeginFire(SLOT);
+		Expect(Near(players.AimControllerPos(SLOT), PosAt(6)) && Near(players.AimControllerAngle(SLOT), AngleAt(6)),
+			"shot aims with the pose of the command that pressed fire");
+		players.EndFire(SLOT);
+
+		for (int tick = 8; tick <= 12; ++tick)
+			Usercmd(players, SLOT, tick, true);
+		Usercmd(players, SLOT, 13, false);
+
+		players.BeginFire(SLOT);
+		Expect(Near(players.AimControllerPos(SLOT), PosAt(12)) && Near(players.AimControllerAngle(SLOT), AngleAt(12)),
+			"repeat shot aims with the pose of the last command that had fire down");
+		players.EndFire(SLOT);
+		Expect(Near(players.AimControllerPos(SLOT), PosAt(13)), "outside of a shot aims with the latest pose");
+
+		// A resent older command doesn't move the fire tick back
+		Usercmd(players, SLOT, 9, true);
+		players.m_ControllerPos[SLOT] = PosAt(13);
+		players.BeginFire(SLOT);
+		Expect(Near(players.AimControllerPos(SLOT), PosAt(12)), "resent command doesn't move the fire tick back");
+		players.EndFire(SLOT);
+
+		// Leaving VR forgets the fire tick
+		players.SetUsingVR(SLOT, false);
+		Expect(players.m_FireTick[SLOT] == -1 && players.m_PoseHistory[SLOT].IsEmpty(), "leaving VR resets the slot");
+	}
+
+	// The server reads a whole packet of commands before it simulates the first of them
+	void TestSimulatedCommand()
+	{
+		constexpr int SLOT = 5;
+		PlayerVRTable players;
+
+		for (int tick = 1; tick <= 9; ++tick)
+			Usercmd(players, SLOT, tick, false);
+
+		// One packet: fire pressed on tick 10 and held through 11, released on 12
+		Usercmd(players, SLOT, 10, true);
+		Usercmd(players, SLOT, 11, true);
+		Usercmd(players, SLOT, 12, false);
+
+		// Simulating tick 10 fires
+		players.BeginCommand(SLOT, 10);
+		players.BeginFire(SLOT);
+		Expect(Near(players.AimControllerPos(SLOT), PosAt(10)) && Near(players.AimControllerAngle(SLOT), AngleAt(10)),
+			"shot from the older command in the packet aims with its pose");
+		players.EndFire(SLOT);
+		players.EndCommand(SLOT);
+
+		// So does one fired while simulating tick 11
+		players.BeginCommand(SLOT, 11);
+		players.BeginFire(SLOT);
+		Expect(Near(players.AimControllerPos(SLOT), PosAt(11)), "shot from the second command aims with its pose");
+		players.EndFire(SLOT);
+		players.EndCommand(SLOT);
+
+		Expect(players.m_RunTick[SLOT] == -1, "no command is simulated after the last one ended");
+		Expect(Near(players.AimControllerPos(SLOT), PosAt(12)), "outside of a shot aims with the latest pose");
+	}
+}
+
+int main()
+{
+	TestSample();
+	TestOrdering();
+	TestFirePose();
+	TestSimulatedCommand();
+
+	if (g_Failures)
+	{
+		printf("%d check(s) failed\n", g_Failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}
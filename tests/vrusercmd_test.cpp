@@ -0,0 +1,444 @@
+// Round trip checks for the usercmd pose codec: every delta mode, the limits of the smallest-three rotations and the
+// marker/version/length header. Ends with a measurement of the bits a command costs over a simulated session,
+// against the old encoding that sent only the right controller.
+#include "vrusercmd.h"
+#include "bitbuf.h"
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+namespace
+{
+	constexpr float PI = 3.14159265358979f;
+
+	// Mirrors of the limits in vrusercmd.cpp
+	constexpr int HEADER_BITS = 8 + 3 + 9;
+	constexpr int ROT_MAX = 511;
+	constexpr int ROT_BITS = 10;
+	constexpr int POS_BITS = 18;
+	constexpr int POS_NEAR_BITS = 10;
+	constexpr int32_t POS_MAX = MAX_COORD_INTEGER * COORD_DENOMINATOR_LOWPRECISION - 1;
+
+	int g_Failures = 0;
+
+	void Expect(bool condition, const char *what)
+	{
+		if (!condition)
+		{
+			printf("FAILED: %s\n", what);
+			++g_Failures;
+		}
+	}
+
+	bool SamePose(const QuantizedPose &a, const QuantizedPose &b)
+	{
+		return memcmp(&a, &b, sizeof(QuantizedPose)) == 0;
+	}
+
+	bool SamePayload(const VRUsercmdPayload &a, const VRUsercmdPayload &b)
+	{
+		if (a.m_DeviceMask != b.m_DeviceMask)
+			return false;
+
+		for (int device = 0; device < VRDevice_Count; ++device)
+		{
+			if (a.HasPose((VRUsercmdDevice)device) && !SamePose(a.m_Poses[device], b.m_Poses[device]))
+				return false;
+		}
+		return true;
+	}
+
+	// Writes 'to' followed by a sentinel, reads it back and checks the reader ends up exactly at the sentinel.
+	// Returns the payload length in bits, -1 if the read failed.
+	int RoundTrip(const VRUsercmdPayload &to, const VRUsercmdPayload *from, VRUsercmdPayload &decoded,
+		const VRUsercmdPayload *readBaseline)
+	{
+		unsigned char data[512] = {};
+		bf_write write(data, sizeof(data));
+		VRUsercmd::Write(&write, to, from);
+		const int payloadBits = write.GetNumBitsWritten() - HEADER_BITS;
+		write.WriteUBitLong(0xABC, 12);
+
+		bf_read read(data, sizeof(data));
+		Expect(read.ReadChar() == VRUsercmd::MARKER, "payload starts with the marker");
+		const bool valid = VRUsercmd::Read(&read, decoded, readBaseline);
+		Expect(read.ReadUBitLong(12) == 0xABC, "reader stops right after the payload");
+
+		return valid ? payloadBits : -1;
+	}
+
+	int RoundTrip(const VRUsercmdPayload &to, const VRUsercmdPayload *from, VRUsercmdPayload &decoded)
+	{
+		return RoundTrip(to, from, decoded, from);
+	}
+
+	QuantizedPose BasePose()
+	{
+		return { { 1000, -2000, 300 }, { 10, -20, 30 }, 3 };
+	}
+
+	void TestAbsoluteRoundTrip()
+	{
+		VRUsercmdPayload to;
+		to.SetPose(VRDevice_Hmd, Vector(1234.5f, -567.25f, 128.0f), QAngle(-12.0f, 87.5f, 3.0f));
+		to.SetPose(VRDevice_LeftController, Vector(-0.5f, 0.0f, 16000.0f), QAngle(45.0f, -170.0f, 60.0f));
+		to.SetPose(VRDevice_RightController, Vector(1240.03125f, -560.0f, 100.75f), QAngle(0.0f, 0.0f, 0.0f));
+
+		VRUsercmdPayload decoded;
+		Expect(RoundTrip(to, nullptr, decoded) > 0, "absolute payload decodes");
+		Expect(SamePayload(to, decoded), "absolute payload is decoded exactly");
+
+		VRUsercmdPayload partial;
+		partial.SetPose(VRDevice_LeftController, Vector(1.0f, 2.0f, 3.0f), QAngle(0.0f, 90.0f, 0.0f));
+		Expect(RoundTrip(partial, nullptr, decoded) > 0, "payload with one device decodes");
+		Expect(decoded.m_DeviceMask == 1 << VRDevice_LeftController, "device mask is kept");
+		Expect(SamePayload(partial, decoded), "payload with one device is decoded exactly");
+	}
+
+	void TestDeltaModes()
+	{
+		struct Case
+		{
+			const char *name;
+			int32_t posDelta[3];
+			int32_t rotDelta[3];
+			bool changeLargest;
+			int posBits;		// Including the 2 bit mode
+			int rotBits;
+		};
+
+		const Case cases[] =
+		{
+			{ "unchanged", { 0, 0, 0 }, { 0, 0, 0 }, false, 2, 2 },
+			{ "small position delta", { 15, -16, 1 }, { 0, 0, 0 }, false, 2 + 3 * 5, 2 },
+			{ "large position delta", { 16, 0, 0 }, { 0, 0, 0 }, false, 2 + 3 * 9, 2 },
+			{ "large position delta, negative limit", { -256, 255, 0 }, { 0, 0, 0 }, false, 2 + 3 * 9, 2 },
+			{ "absolute position", { 256, 0, 0 }, { 0, 0, 0 }, false, 2 + 3 * POS_BITS, 2 },
+			{ "small rotation delta", { 0, 0, 0 }, { 7, -8, 1 }, false, 2, 2 + 3 * 4 },
+			{ "large rotation delta", { 0, 0, 0 }, { 8, 0, -128 }, false, 2, 2 + 3 * 8 },
+			{ "absolute rotation", { 0, 0, 0 }, { 128, 0, 0 }, false, 2, 2 + 2 + 3 * ROT_BITS },
+			{ "largest component changed", { 0, 0, 0 }, { 0, 0, 0 }, true, 2, 2 + 2 + 3 * ROT_BITS },
+			{ "both small", { 3, -4, 5 }, { -1, 2, 0 }, false, 2 + 3 * 5, 2 + 3 * 4 },
+		};
+
+		for (const Case &c : cases)
+		{
+			VRUsercmdPayload from;
+			from.m_DeviceMask = 1 << VRDevice_RightController;
+			from.m_Poses[VRDevice_RightController] = BasePose();
+
+			VRUsercmdPayload to = from;
+			QuantizedPose &pose = to.m_Poses[VRDevice_RightController];
+			for (int i = 0; i < 3; ++i)
+			{
+				pose.m_Pos[i] += c.posDelta[i];
+				pose.m_Rot[i] += c.rotDelta[i];
+			}
+			if (c.changeLargest)
+				pose.m_RotLargest = 1;
+
+			VRUsercmdPayload decoded;
+			const int bits = RoundTrip(to, &from, decoded);
+
+			char what[128];
+			snprintf(what, sizeof(what), "%s: decodes exactly", c.name);
+			Expect(bits > 0 && SamePayload(to, decoded), what);
+
+			snprintf(what, sizeof(what), "%s: payload is %d bits, expected %d", c.name, bits, 4 + c.posBits + c.rotBits);
+			Expect(bits == 4 + c.posBits + c.rotBits, what);
+		}
+
+		// A device the baseline didn't have is sent absolute, even though the payload has a baseline. Near the
+		// headset that's relative to it.
+		VRUsercmdPayload from;
+		from.m_DeviceMask = 1 << VRDevice_Hmd;
+		from.m_Poses[VRDevice_Hmd] = BasePose();
+
+		VRUsercmdPayload to = from;
+		to.m_DeviceMask |= 1 << VRDevice_LeftController;
+		to.m_Poses[VRDevice_LeftController] = BasePose();
+		to.m_Poses[VRDevice_LeftController].m_Pos[2] -= 511;
+
+		VRUsercmdPayload decoded;
+		int bits = RoundTrip(to, &from, decoded);
+		Expect(bits == 4 + (2 + 2) + (2 + 1 + 3 * POS_NEAR_BITS + 2 + 2 + 3 * ROT_BITS), "new device near the headset is sent relative to it");
+		Expect(SamePayload(to, decoded), "new device near the headset decodes exactly");
+
+		to.m_Poses[VRDevice_LeftController].m_Pos[2] -= 2;
+		bits = RoundTrip(to, &from, decoded);
+		Expect(bits == 4 + (2 + 2) + (2 + 1 + 3 * POS_BITS + 2 + 2 + 3 * ROT_BITS), "new device far from the headset is sent absolute");
+		Expect(SamePayload(to, decoded), "new device far from the headset decodes exactly");
+
+		// The controllers are delta encoded after moving them along with the headset
+		from.m_DeviceMask = to.m_DeviceMask = (1 << VRDevice_Hmd) | (1 << VRDevice_RightController);
+		from.m_Poses[VRDevice_RightController] = BasePose();
+		to = from;
+		QuantizedPose &hmd = to.m_Poses[VRDevice_Hmd];
+		QuantizedPose &controller = to.m_Poses[VRDevice_RightController];
+		hmd.m_Pos[0] += 100;
+		hmd.m_Pos[1] -= 40;
+		controller.m_Pos[0] += 100;
+		controller.m_Pos[1] -= 40 - 3;
+
+		bits = RoundTrip(to, &from, decoded);
+		Expect(bits == 4 + (2 + 3 * 9 + 2) + (2 + 3 * 5 + 2), "controller moving with the headset is a small delta");
+		Expect(SamePayload(to, decoded), "controller moving with the headset decodes exactly");
+	}
+
+	// Angle in degrees between the orientations the two angles describe
+	float AngleBetween(const QAngle &a, const QAngle &b)
+	{
+		Vector forwardA, rightA, upA, forwardB, rightB, upB;
+		QAngle::AngleVectors(a, &forwardA, &rightA, &upA);
+		QAngle::AngleVectors(b, &forwardB, &rightB, &upB);
+
+		const float forwardDot = forwardA.x * forwardB.x + forwardA.y * forwardB.y + forwardA.z * forwardB.z;
+		const float upDot = upA.x * upB.x + upA.y * upB.y + upA.z * upB.z;
+		const float dot = fminf(1.0f, fminf(forwardDot, upDot));
+		return acosf(dot) * 180.0f / PI;
+	}
+
+	void TestRotationLimits()
+	{
+		const QAngle angles[] =
+		{
+			QAngle(0.0f, 0.0f, 0.0f),
+			QAngle(0.0f, 90.0f, 0.0f),			// Two components of 1/sqrt(2), the edge of the smallest-three range
+			QAngle(0.0f, -90.0f, 0.0f),
+			QAngle(0.0f, 180.0f, 0.0f),			// w = 0
+			QAngle(0.0f, -180.0f, 0.0f),
+			QAngle(0.0f, 0.0f, 180.0f),
+			QAngle(0.0f, 300.0f, 0.0f),			// Largest component negative
+			QAngle(-89.0f, 30.0f, 0.0f),
+			QAngle(89.0f, -120.0f, 45.0f),
+			QAngle(45.0f, 45.0f, 45.0f),
+			QAngle(-30.0f, -150.0f, 170.0f),
+			QAngle(12.5f, 179.9f, -179.9f),
+		};
+
+		for (const QAngle &angle : angles)
+		{
+			VRUsercmdPayload to;
+			to.SetPose(VRDevice_Hmd, Vector(0.0f, 0.0f, 0.0f), angle);
+
+			const QuantizedPose &pose = to.m_Poses[VRDevice_Hmd];
+			char what[128];
+			snprintf(what, sizeof(what), "(%g %g %g) stays within %d bits", angle.x, angle.y, angle.z, 10);
+			Expect(abs(pose.m_Rot[0]) <= ROT_MAX && abs(pose.m_Rot[1]) <= ROT_MAX && abs(pose.m_Rot[2]) <= ROT_MAX
+				&& pose.m_RotLargest < 4, what);
+
+			VRUsercmdPayload decoded;
+			Expect(RoundTrip(to, nullptr, decoded) > 0 && SamePayload(to, decoded), "rotation decodes exactly");
+
+			Vector pos;
+			QAngle result;
+			Expect(decoded.GetPose(VRDevice_Hmd, pos, result), "decoded payload has the pose");
+
+			const float error = AngleBetween(angle, result);
+			snprintf(what, sizeof(what), "(%g %g %g) comes back within 0.25 degrees, off by %.3f", angle.x, angle.y, angle.z, error);
+			Expect(error < 0.25f, what);
+		}
+
+		// Positions beyond the map are clamped to the coordinate range
+		VRUsercmdPayload to;
+		to.SetPose(VRDevice_RightController, Vector(1e6f, -1e6f, MAX_COORD_INTEGER - 0.5f), QAngle(0.0f, 0.0f, 0.0f));
+		const QuantizedPose &pose = to.m_Poses[VRDevice_RightController];
+		Expect(pose.m_Pos[0] == POS_MAX && pose.m_Pos[1] == -POS_MAX && pose.m_Pos[2] == POS_MAX - 3, "positions are clamped");
+
+		VRUsercmdPayload decoded;
+		Expect(RoundTrip(to, nullptr, decoded) > 0 && SamePayload(to, decoded), "clamped position decodes exactly");
+	}
+
+	void TestHeader()
+	{
+		// Every device absolute with the largest coordinates, sent with a baseline so the modes are included too
+		VRUsercmdPayload from;
+		VRUsercmdPayload to;
+		for (int device = 0; device < VRDevice_Count; ++device)
+		{
+			from.SetPose((VRUsercmdDevice)device, Vector(0.0f, 0.0f, 0.0f), QAngle(0.0f, 0.0f, 0.0f));
+			to.SetPose((VRUsercmdDevice)device, Vector(-16383.96875f, 16383.96875f, -16383.96875f), QAngle(45.0f, 135.0f, -60.0f));
+		}
+
+		unsigned char data[512] = {};
+		bf_write write(data, sizeof(data));
+		VRUsercmd::Write(&write, to, &from);
+		Expect(!write.IsOverflowed(), "worst case payload fits the buffer");
+
+		bf_read read(data, sizeof(data));
+		Expect(read.ReadChar() == VRUsercmd::MARKER, "marker");
+		Expect(read.ReadUBitLong(3) == VRUsercmd::VERSION, "version");
+		const int length = read.ReadUBitLong(9);
+		Expect(length == write.GetNumBitsWritten() - HEADER_BITS, "length is the payload size");
+		Expect(length < 1 << 9, "worst case payload fits the 9 bit length");
+		printf("worst case payload: %d bits\n", length);
+
+		// A version this reader doesn't know is skipped by its length
+		unsigned char future[64] = {};
+		bf_write futureWrite(future, sizeof(future));
+		futureWrite.WriteChar(VRUsercmd::MARKER);
+		futureWrite.WriteUBitLong(VRUsercmd::VERSION + 1, 3);
+		futureWrite.WriteUBitLong(37, 9);
+		futureWrite.WriteUBitLong(0x1FFFFFFF, 29);
+		futureWrite.WriteUBitLong(0xFF, 8);
+		futureWrite.WriteUBitLong(0xABC, 12);
+
+		bf_read futureRead(future, sizeof(future));
+		VRUsercmdPayload decoded;
+		futureRead.ReadChar();
+		Expect(!VRUsercmd::Read(&futureRead, decoded, nullptr), "unknown version isn't decoded");
+		Expect(futureRead.ReadUBitLong(12) == 0xABC, "unknown version is skipped exactly");
+
+		// A delta payload without the baseline can't be decoded, but is still consumed
+		VRUsercmdPayload delta = from;
+		delta.m_Poses[VRDevice_Hmd].m_Pos[0] += 5;
+		Expect(RoundTrip(delta, &from, decoded, nullptr) == -1, "delta without a baseline isn't decoded");
+
+		// Cut off in the middle of the payload
+		unsigned char truncated[8] = {};
+		memcpy(truncated, data, sizeof(truncated));
+		bf_read truncatedRead(truncated, sizeof(truncated));
+		truncatedRead.ReadChar();
+		Expect(!VRUsercmd::Read(&truncatedRead, decoded, &from), "truncated payload isn't decoded");
+	}
+
+	void TestHistory()
+	{
+		VRUsercmdHistory history;
+		VRUsercmdPayload payload;
+		payload.SetPose(VRDevice_Hmd, Vector(1.0f, 2.0f, 3.0f), QAngle(0.0f, 0.0f, 0.0f));
+
+		Expect(history.Find(0) == nullptr, "command 0 never has a baseline");
+		history.Store(0, payload);
+		Expect(history.Find(0) == nullptr, "command 0 never has a baseline, even if stored");
+
+		history.Store(100, payload);
+		Expect(history.Find(100) && SamePayload(*history.Find(100), payload), "stored payload is found");
+		Expect(history.Find(36) == nullptr, "older command in the same slot isn't returned");
+
+		history.Store(164, VRUsercmdPayload());
+		Expect(history.Find(100) == nullptr, "overwritten command isn't returned");
+
+		// A new connection numbers its commands from the start again
+		history.Store(5, payload);
+		history.Clear();
+		Expect(history.Find(5) == nullptr && history.Find(164) == nullptr, "cleared history has no baselines");
+		history.Store(5, payload);
+		Expect(history.Find(5) != nullptr, "cleared history stores again");
+	}
+
+	void TestBaselineCommand()
+	{
+		constexpr int KEYFRAME = VRUsercmd::KEYFRAME_INTERVAL;
+
+		Expect(VRUsercmd::BaselineCommand(KEYFRAME * 3 + 5, KEYFRAME * 3 + 4) == KEYFRAME * 3 + 4, "deltas against the previous command in the packet");
+		Expect(VRUsercmd::BaselineCommand(KEYFRAME * 3 + 5, 0) == KEYFRAME * 3, "first command in a packet deltas against the last keyframe");
+		Expect(VRUsercmd::BaselineCommand(KEYFRAME * 3, KEYFRAME * 3 - 1) == 0, "keyframe has no baseline");
+		Expect(VRUsercmd::BaselineCommand(KEYFRAME * 3, 0) == 0, "keyframe first in a packet has no baseline");
+		Expect(VRUsercmd::BaselineCommand(5, 0) == 0, "no keyframe before the first one");
+	}
+
+	Vector Offset(const Vector &a, float x, float y, float z)
+	{
+		return Vector(a.x + x, a.y + y, a.z + z);
+	}
+
+	// The poses of a minute of play at 90 commands a second: walking around, looking around and waving both hands
+	struct SimulatedCommand
+	{
+		VRUsercmdPayload m_Payload;
+		Vector m_RightPos;
+		QAngle m_RightAngle;
+	};
+
+	SimulatedCommand SimulateCommand(int command)
+	{
+		const float t = command / 90.0f;
+
+		// Walking a circle at 150 units/s, looking back and forth
+		const Vector origin(1200.0f + 750.0f * sinf(0.2f * t), -340.0f - 750.0f * cosf(0.2f * t), 64.0f);
+		const float yaw = 60.0f * sinf(0.5f * t);
+
+		const Vector hmdPos = Offset(origin, 2.0f * sinf(0.7f * t), 1.5f * cosf(0.9f * t), 64.0f + sinf(1.3f * t));
+		const QAngle hmdAngle(10.0f * sinf(0.8f * t), yaw + 20.0f * sinf(1.1f * t), 3.0f * sinf(0.6f * t));
+
+		const Vector leftPos = Offset(origin, 12.0f * sinf(1.9f * t), 10.0f + 8.0f * cosf(1.7f * t), 40.0f + 6.0f * sinf(2.3f * t));
+		const QAngle leftAngle(30.0f * sinf(1.5f * t), yaw + 40.0f * sinf(1.2f * t), 45.0f * sinf(1.8f * t));
+
+		SimulatedCommand result;
+		result.m_RightPos = Offset(origin, 14.0f * sinf(2.1f * t), -10.0f + 9.0f * cosf(1.6f * t), 42.0f + 7.0f * sinf(2.5f * t));
+		result.m_RightAngle = QAngle(25.0f * sinf(1.4f * t), yaw + 35.0f * sinf(1.3f * t), 50.0f * sinf(2.0f * t));
+
+		result.m_Payload.SetPose(VRDevice_Hmd, hmdPos, hmdAngle);
+		result.m_Payload.SetPose(VRDevice_LeftController, leftPos, leftAngle);
+		result.m_Payload.SetPose(VRDevice_RightController, result.m_RightPos, result.m_RightAngle);
+		return result;
+	}
+
+	// Bits per command sent, written the way the engine packs them: 30 packets a second, each with the three new
+	// commands and the two before them again (cl_cmdbackup 2). The first command in a packet has no baseline.
+	void MeasureBitBudget()
+	{
+		constexpr int NUM_COMMANDS = 90 * 60;
+		constexpr int NEW_COMMANDS = 3;
+		constexpr int BACKUP_COMMANDS = 2;
+
+		VRUsercmdHistory sent;
+		long long firstBits = 0, restBits = 0, legacyBits = 0;
+		int firstCount = 0, restCount = 0;
+
+		for (int newest = NEW_COMMANDS + BACKUP_COMMANDS; newest <= NUM_COMMANDS; newest += NEW_COMMANDS)
+		{
+			for (int command = newest - NEW_COMMANDS - BACKUP_COMMANDS + 1, from = 0; command <= newest; from = command++)
+			{
+				const SimulatedCommand simulated = SimulateCommand(command);
+				sent.Store(command, simulated.m_Payload);
+
+				VRUsercmdPayload decoded;
+				const int bits = RoundTrip(simulated.m_Payload, sent.Find(VRUsercmd::BaselineCommand(command, from)), decoded);
+				Expect(bits > 0 && SamePayload(simulated.m_Payload, decoded), "simulated command decodes exactly");
+				(from ? restBits : firstBits) += HEADER_BITS + bits;
+				++(from ? restCount : firstCount);
+
+				unsigned char data[64];
+				bf_write legacy(data, sizeof(data));
+				legacy.WriteChar(VRUsercmd::LEGACY_MARKER);
+				legacy.WriteBitVec3Coord(simulated.m_RightPos);
+				legacy.WriteBitAngles(simulated.m_RightAngle);
+				legacyBits += legacy.GetNumBitsWritten();
+			}
+		}
+
+		const double first = (double)firstBits / firstCount;
+		const double rest = (double)restBits / restCount;
+		const double average = (double)(firstBits + restBits) / (firstCount + restCount);
+		const double legacy = (double)legacyBits / (firstCount + restCount);
+
+		printf("bits per command: %.1f on average, %.1f first in a packet, %.1f after that, legacy right controller only %.1f\n",
+			average, first, rest, legacy);
+
+		Expect(rest < first, "deltas are smaller than the first command of a packet");
+		Expect(average < legacy, "three devices cost less than the legacy right controller pose");
+	}
+}
+
+int main()
+{
+	TestAbsoluteRoundTrip();
+	TestDeltaModes();
+	TestRotationLimits();
+	TestHeader();
+	TestHistory();
+	TestBaselineCommand();
+	MeasureBitBudget();
+
+	if (g_Failures)
+	{
+		printf("%d check(s) failed\n", g_Failures);
+		return 1;
+	}
+
+	printf("all checks passed\n");
+	return 0;
+}